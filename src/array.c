@@ -0,0 +1,125 @@
+#include "array.h"
+#include "gc.h"
+#include "list.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Constants
+
+static const size_t ARRAY_MIN_CAP = 4;
+
+// Functions
+
+static Weft_ArrayBuf *new_array_buf(size_t cap)
+{
+	if (cap < ARRAY_MIN_CAP) {
+		cap = ARRAY_MIN_CAP;
+	}
+
+	Weft_ArrayBuf *buf =
+		gc_alloc(sizeof(Weft_ArrayBuf) + cap * sizeof(Weft_Data));
+	buf->cap = cap;
+	buf->len = 0;
+
+	return buf;
+}
+
+static Weft_Array *new_view(Weft_ArrayBuf *buf, size_t start, size_t len)
+{
+	Weft_Array *array = gc_alloc(sizeof(Weft_Array));
+	array->buf = buf;
+	array->start = start;
+	array->len = len;
+
+	return array;
+}
+
+Weft_Array *new_array(size_t cap)
+{
+	return new_view(new_array_buf(cap), 0, 0);
+}
+
+Weft_Array *array_from_list(const Weft_List *list)
+{
+	size_t len = 0;
+	for (const Weft_List *node = list; node; node = node->cdr) {
+		len++;
+	}
+
+	Weft_ArrayBuf *buf = new_array_buf(len);
+	for (; list; list = list->cdr) {
+		buf->data[buf->len++] = list->car;
+	}
+	return new_view(buf, 0, len);
+}
+
+Weft_List *array_to_list(const Weft_Array *array)
+{
+	const Weft_Data *data = array_get_data(array);
+	Weft_List *list = NULL;
+
+	for (size_t i = array->len; i > 0; i--) {
+		list = new_list_node(data[i - 1], list);
+	}
+	return list;
+}
+
+size_t array_get_len(const Weft_Array *array)
+{
+	return array->len;
+}
+
+Weft_Data *array_get_data(const Weft_Array *array)
+{
+	return array->buf->data + array->start;
+}
+
+Weft_Data array_get(const Weft_Array *array, size_t index)
+{
+	return array_get_data(array)[index];
+}
+
+Weft_Array *array_slice(const Weft_Array *array, size_t start, size_t end)
+{
+	return new_view(array->buf, array->start + start, end - start);
+}
+
+Weft_Array *array_push(const Weft_Array *array, Weft_Data data)
+{
+	Weft_ArrayBuf *buf = array->buf;
+	size_t start = array->start;
+
+	if (start + array->len != buf->len || buf->len == buf->cap) {
+		buf = new_array_buf(2 * array->len);
+		memcpy(buf->data,
+		       array_get_data(array),
+		       array->len * sizeof(Weft_Data));
+		buf->len = array->len;
+		start = 0;
+	}
+
+	buf->data[buf->len++] = data;
+	return new_view(buf, start, array->len + 1);
+}
+
+void array_seal(Weft_Array *array)
+{
+	if (array->buf->cap != array->buf->len) {
+		array->buf->cap = array->buf->len;
+	}
+}
+
+void array_print(const Weft_Array *array)
+{
+	const Weft_Data *data = array_get_data(array);
+
+	printf("#[");
+	for (size_t i = 0; i < array->len; i++) {
+		if (i) {
+			printf(" ");
+		}
+		data_print(data[i]);
+	}
+	printf("]");
+}
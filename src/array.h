@@ -0,0 +1,43 @@
+#ifndef WEFT_ARRAY_H
+#define WEFT_ARRAY_H
+
+#include <stddef.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_array_buf Weft_ArrayBuf;
+typedef struct weft_array Weft_Array;
+
+// Local Includes
+
+#include "data.h"
+
+// Data Types
+
+struct weft_array_buf {
+	size_t cap;
+	size_t len;
+	Weft_Data data[];
+};
+
+struct weft_array {
+	Weft_ArrayBuf *buf;
+	size_t start;
+	size_t len;
+};
+
+// Functions
+
+Weft_Array *new_array(size_t cap);
+Weft_Array *array_from_list(const Weft_List *list);
+Weft_List *array_to_list(const Weft_Array *array);
+size_t array_get_len(const Weft_Array *array);
+Weft_Data *array_get_data(const Weft_Array *array);
+Weft_Data array_get(const Weft_Array *array, size_t index);
+Weft_Array *array_slice(const Weft_Array *array, size_t start, size_t end);
+Weft_Array *array_push(const Weft_Array *array, Weft_Data data);
+void array_seal(Weft_Array *array);
+void array_print(const Weft_Array *array);
+
+#endif
@@ -6,8 +6,22 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Constants
+
+static const size_t BUF_MIN_CAP = 64;
+
+// Globals
+
+static _Thread_local size_t realloc_count;
+
+// Functions
+
 Weft_Buf *new_buf(size_t cap)
 {
+	if (cap < BUF_MIN_CAP) {
+		cap = BUF_MIN_CAP;
+	}
+
 	Weft_Buf *buf = malloc(sizeof(Weft_Buf) + cap);
 	if (!buf) {
 		fprintf(stderr,
@@ -18,6 +32,7 @@ Weft_Buf *new_buf(size_t cap)
 	}
 
 	buf->cap = cap;
+	buf->min = cap;
 	buf->at = 0;
 
 	return buf;
@@ -49,20 +64,32 @@ static Weft_Buf *realloc_buf(Weft_Buf *buf, size_t cap)
 		exit(1);
 	}
 	buf->cap = cap;
+	realloc_count++;
 
 	return buf;
 }
 
+size_t buf_get_realloc_count(void)
+{
+	return realloc_count;
+}
+
 static size_t expand_cap(const Weft_Buf *buf, size_t request)
 {
 	return 2 * (buf->at + request);
 }
 
-Weft_Buf *buf_push(Weft_Buf *buf, const void *src, size_t size)
+Weft_Buf *buf_reserve(Weft_Buf *buf, size_t size)
 {
 	if (buf->at + size > buf->cap) {
 		buf = realloc_buf(buf, expand_cap(buf, size));
 	}
+	return buf;
+}
+
+Weft_Buf *buf_push(Weft_Buf *buf, const void *src, size_t size)
+{
+	buf = buf_reserve(buf, size);
 
 	memmove(buf->raw + buf->at, src, size);
 	buf->at += size;
@@ -77,15 +104,15 @@ const void *buf_peek(const Weft_Buf *buf, size_t size)
 
 static bool is_shrinkable(const Weft_Buf *buf)
 {
-	return buf->at <= buf->cap / 4;
+	return buf->cap > buf->min && buf->at <= buf->cap / 4;
 }
 
 static size_t shrink_cap(const Weft_Buf *buf)
 {
-	return (buf->at + buf->cap) / 2;
+	return (buf->cap / 2 > buf->min) ? buf->cap / 2 : buf->min;
 }
 
-static Weft_Buf *shrink_buf(Weft_Buf *buf)
+Weft_Buf *buf_shrink(Weft_Buf *buf)
 {
 	if (is_shrinkable(buf)) {
 		return realloc_buf(buf, shrink_cap(buf));
@@ -93,10 +120,16 @@ static Weft_Buf *shrink_buf(Weft_Buf *buf)
 	return buf;
 }
 
+Weft_Buf *buf_clear(Weft_Buf *buf)
+{
+	buf->at = 0;
+	return buf;
+}
+
 Weft_Buf *buf_drop(Weft_Buf *buf, size_t size)
 {
 	buf->at -= size;
-	return shrink_buf(buf);
+	return buf_shrink(buf);
 }
 
 Weft_Buf *buf_pop(void *dest, Weft_Buf *buf, size_t size)
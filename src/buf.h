@@ -2,15 +2,21 @@
 #define WEFT_BUF_H
 
 #include <stddef.h>
+#include <string.h>
 
 // Forward Declarations
 
 typedef struct weft_buf Weft_Buf;
 
+// Local Includes
+
+#include "data.h"
+
 // Data Types
 
 struct weft_buf {
 	size_t cap;
+	size_t min;
 	size_t at;
 	char raw[];
 };
@@ -20,9 +26,43 @@ struct weft_buf {
 Weft_Buf *new_buf(size_t cap);
 size_t buf_get_at(const Weft_Buf *buf);
 Weft_Buf *buf_free(Weft_Buf *buf);
+Weft_Buf *buf_reserve(Weft_Buf *buf, size_t size);
 Weft_Buf *buf_push(Weft_Buf *buf, const void *src, size_t size);
 const void *buf_peek(const Weft_Buf *buf, size_t size);
 Weft_Buf *buf_drop(Weft_Buf *buf, size_t size);
 Weft_Buf *buf_pop(void *dest, Weft_Buf *buf, size_t size);
+Weft_Buf *buf_shrink(Weft_Buf *buf);
+Weft_Buf *buf_clear(Weft_Buf *buf);
+size_t buf_get_realloc_count(void);
+
+static inline Weft_Buf *buf_push_ptr(Weft_Buf *buf, const void *ptr)
+{
+	if (buf->at + sizeof(ptr) > buf->cap) {
+		buf = buf_reserve(buf, sizeof(ptr));
+	}
+	memcpy(buf->raw + buf->at, &ptr, sizeof(ptr));
+	buf->at += sizeof(ptr);
+
+	return buf;
+}
+
+static inline Weft_Buf *buf_pop_ptr(void *dest, Weft_Buf *buf)
+{
+	buf->at -= sizeof(void *);
+	memcpy(dest, buf->raw + buf->at, sizeof(void *));
+
+	return (buf->at <= buf->cap / 4) ? buf_shrink(buf) : buf;
+}
+
+static inline Weft_Buf *buf_push_data(Weft_Buf *buf, Weft_Data data)
+{
+	if (buf->at + sizeof(data) > buf->cap) {
+		buf = buf_reserve(buf, sizeof(data));
+	}
+	memcpy(buf->raw + buf->at, &data, sizeof(data));
+	buf->at += sizeof(data);
+
+	return buf;
+}
 
 #endif
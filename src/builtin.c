@@ -1,9 +1,63 @@
 #include "builtin.h"
+#include "array.h"
+#include "buf.h"
+#include "char.h"
+#include "data.h"
+#include "dict.h"
+#include "effect.h"
+#include "eval.h"
+#include "fold.h"
 #include "gc.h"
+#include "list.h"
+#include "map.h"
+#include "memo.h"
+#include "pvec.h"
+#include "sort.h"
+#include "str.h"
+#include "thread.h"
+#include "vec.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
+// Forward Declarations
+
+typedef struct weft_builtin_variant_def Weft_BuiltinVariantDef;
+typedef struct weft_builtin_def Weft_BuiltinDef;
+typedef struct weft_builtin_sort_by Weft_BuiltinSortBy;
+
+// Data Types
+
+struct weft_builtin_variant_def {
+	bool (*int_fn)(Weft_EvalState *);
+	bool (*int_binary)(Weft_EvalState *, Weft_Data *);
+	bool (*float_fn)(Weft_EvalState *);
+	bool (*float_binary)(Weft_EvalState *, Weft_Data *);
+};
+
+struct weft_builtin_def {
+	const char *name;
+	bool (*fn)(Weft_EvalState *);
+	bool (*binary)(Weft_EvalState *, Weft_Data *);
+	const Weft_BuiltinVariantDef *variants;
+	bool pure;
+	bool known;
+	unsigned in;
+	unsigned out;
+};
+
+struct weft_builtin_sort_by {
+	Weft_EvalState *W;
+	Weft_Data fn;
+};
+
+// Globals
+
+static Weft_Map *builtin_map;
+
+// Functions
+
 Weft_Builtin *
 new_builtin_n(const char *name, size_t name_len, bool (*fn)(Weft_EvalState *))
 {
@@ -11,7 +65,34 @@ new_builtin_n(const char *name, size_t name_len, bool (*fn)(Weft_EvalState *))
 	memcpy(builtin->name, name, name_len);
 	builtin->name[name_len] = 0;
 	builtin->fn = fn;
+	builtin->binary = NULL;
+	builtin->int_variant = NULL;
+	builtin->float_variant = NULL;
+	builtin->pure = false;
+	builtin->effect = effect_unknown(0);
+
+	return builtin;
+}
+
+void builtin_mark(Weft_Builtin *builtin)
+{
+	if (gc_mark(builtin)) {
+		return;
+	} else if (builtin->int_variant) {
+		gc_mark(builtin->int_variant);
+		gc_mark(builtin->float_variant);
+	}
+}
 
+Weft_Builtin *builtin_specialize(Weft_Builtin *builtin, const Weft_Data *arg)
+{
+	if (!builtin->int_variant || arg[0].type != arg[1].type) {
+		return builtin;
+	} else if (arg[0].type == WEFT_DATA_INT) {
+		return builtin->int_variant;
+	} else if (arg[0].type == WEFT_DATA_FLOAT) {
+		return builtin->float_variant;
+	}
 	return builtin;
 }
 
@@ -19,3 +100,1631 @@ void builtin_print(const Weft_Builtin *builtin)
 {
 	printf("%s", builtin->name);
 }
+
+static bool type_error(Weft_EvalState *W, const char *name, Weft_Data data)
+{
+	return eval_error(W, "%s: unexpected argument type %u", name, data.type);
+}
+
+static bool builtin_eval(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "eval")) {
+		return false;
+	}
+
+	Weft_Data data = eval_pop(W);
+	if (data.type == WEFT_DATA_LIST) {
+		eval_call(W, data.ptr);
+		return true;
+	}
+	return eval_data(W, data);
+}
+
+static Weft_Effect get_quote_effect(Weft_Data fn)
+{
+	if (fn.type == WEFT_DATA_LIST) {
+		return effect_of_list(fn.ptr);
+	}
+	return effect_of_data(fn);
+}
+
+static bool builtin_memo(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "memo")) {
+		return false;
+	}
+
+	Weft_Data fn = *eval_peek(W, 1);
+	Weft_Effect effect = get_quote_effect(fn);
+	if (!effect_is_known(effect)) {
+		return eval_error(W, "memo: stack effect is not known");
+	} else if (!eval_require(W, effect.in + 1, "memo")) {
+		return false;
+	}
+	eval_pop(W);
+
+	const Weft_Data *out = memo_lookup(fn, eval_peek(W, effect.in), effect.in);
+	if (out) {
+		for (unsigned i = 0; i < effect.in; i++) {
+			eval_pop(W);
+		}
+		for (unsigned i = 0; i < effect.out; i++) {
+			eval_push(W, out[i]);
+		}
+		return true;
+	} else if (!fold_is_pure(fn)) {
+		return eval_error(W, "memo: quotation is not pure");
+	}
+
+	Weft_MemoEntry *entry =
+		new_memo_entry(fn, eval_peek(W, effect.in), effect.in, effect.out);
+	if (!eval_apply(W, fn)) {
+		memo_entry_free(entry);
+		return false;
+	}
+
+	memo_insert(entry, eval_peek(W, effect.out));
+	return true;
+}
+
+static bool call_quote(Weft_EvalState *W,
+                       const char *name,
+                       Weft_Data fn,
+                       const Weft_Data *arg,
+                       unsigned count,
+                       Weft_Data *dest)
+{
+	size_t depth = eval_get_depth(W);
+	for (unsigned i = 0; i < count; i++) {
+		eval_push(W, arg[i]);
+	}
+
+	if (!eval_apply(W, fn)) {
+		return false;
+	} else if (eval_get_depth(W) != depth + 1) {
+		return eval_error(W, "%s: quotation must leave one value", name);
+	}
+
+	*dest = eval_pop(W);
+	return true;
+}
+
+static Weft_List *append(Weft_List **list_p, Weft_List *node, Weft_Data data)
+{
+	Weft_List *next = new_list_node(data, NULL);
+	if (node) {
+		node->cdr = next;
+	} else {
+		*list_p = next;
+	}
+	return next;
+}
+
+static bool
+get_seq_len(size_t *len, Weft_EvalState *W, const char *name, Weft_Data seq)
+{
+	switch (seq.type) {
+	case WEFT_DATA_LIST:
+		*len = 0;
+		for (const Weft_List *list = seq.ptr; list; list = list->cdr) {
+			(*len)++;
+		}
+		return true;
+	case WEFT_DATA_ARRAY:
+		*len = array_get_len(seq.ptr);
+		return true;
+	case WEFT_DATA_VEC:
+		*len = ((const Weft_Vec *)seq.ptr)->len;
+		return true;
+	default:
+		return type_error(W, name, seq);
+	}
+}
+
+static Weft_Data next_item(Weft_Data seq, const Weft_List **src_p, size_t i)
+{
+	if (seq.type == WEFT_DATA_ARRAY) {
+		return array_get(seq.ptr, i);
+	} else if (seq.type == WEFT_DATA_VEC) {
+		return vec_get(seq.ptr, i);
+	}
+
+	Weft_Data data = (*src_p)->car;
+	*src_p = (*src_p)->cdr;
+	return data;
+}
+
+static Weft_Data new_seq(Weft_Data seq, const Weft_Data *data, size_t len)
+{
+	if (seq.type == WEFT_DATA_VEC) {
+		Weft_VecType type = ((const Weft_Vec *)seq.ptr)->type;
+		return data_vec(vec_from_data(type, data, len));
+	} else if (seq.type != WEFT_DATA_LIST) {
+		Weft_Array *array = new_array(len);
+		for (size_t i = 0; i < len; i++) {
+			array = array_push(array, data[i]);
+		}
+		return data_array(array);
+	}
+
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+	for (size_t i = 0; i < len; i++) {
+		node = append(&list, node, data[i]);
+	}
+	return data_list(list);
+}
+
+static bool iterate(Weft_EvalState *W, const char *name, bool keep)
+{
+	size_t len = 0;
+	if (!eval_require(W, 2, name)
+	    || !get_seq_len(&len, W, name, *eval_peek(W, 2))) {
+		return false;
+	}
+
+	Weft_Data fn = eval_pop(W);
+	Weft_Data seq = eval_pop(W);
+	const Weft_List *src = seq.ptr;
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+	Weft_Array *array = NULL;
+
+	if (seq.type != WEFT_DATA_LIST) {
+		array = new_array(len);
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		Weft_Data data = next_item(seq, &src, i);
+		Weft_Data result;
+
+		if (!call_quote(W, name, fn, &data, 1, &result)) {
+			return false;
+		} else if (!keep) {
+			data = result;
+		} else if (result.type != WEFT_DATA_INT) {
+			return type_error(W, name, result);
+		} else if (!result.inum) {
+			continue;
+		}
+
+		if (array) {
+			array = array_push(array, data);
+		} else {
+			node = append(&list, node, data);
+		}
+	}
+
+	if (!array) {
+		eval_push(W, data_list(list));
+	} else if (seq.type == WEFT_DATA_VEC && keep) {
+		eval_push(W,
+		          new_seq(seq, array_get_data(array), array_get_len(array)));
+	} else {
+		eval_push(W, data_array(array));
+	}
+	return true;
+}
+
+static bool builtin_map_seq(Weft_EvalState *W)
+{
+	return iterate(W, "map", false);
+}
+
+static bool builtin_filter(Weft_EvalState *W)
+{
+	return iterate(W, "filter", true);
+}
+
+static Weft_Buf *get_seq_data(Weft_Data seq, size_t len)
+{
+	Weft_Buf *buf = new_buf(len * sizeof(Weft_Data));
+	const Weft_List *src = seq.ptr;
+
+	for (size_t i = 0; i < len; i++) {
+		buf = buf_push_data(buf, next_item(seq, &src, i));
+	}
+	return buf;
+}
+
+static bool builtin_pmap(Weft_EvalState *W)
+{
+	size_t len = 0;
+	if (!eval_require(W, 2, "pmap")
+	    || !get_seq_len(&len, W, "pmap", *eval_peek(W, 2))) {
+		return false;
+	}
+
+	Weft_Data fn = eval_pop(W);
+	Weft_Data seq = eval_pop(W);
+	Weft_Buf *buf = get_seq_data(seq, len);
+	Weft_Data *data = (Weft_Data *)buf->raw;
+
+	bool ok = thread_map(data, data, len, fn);
+	if (ok && seq.type == WEFT_DATA_LIST) {
+		eval_push(W, new_seq(seq, data, len));
+	} else if (ok) {
+		eval_push(W, new_seq(data_array(NULL), data, len));
+	}
+	buf_free(buf);
+
+	return ok;
+}
+
+static bool builtin_sort(Weft_EvalState *W)
+{
+	size_t len = 0;
+	if (!eval_require(W, 1, "sort")
+	    || !get_seq_len(&len, W, "sort", *eval_peek(W, 1))) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	Weft_Buf *buf = get_seq_data(arg[0], len);
+
+	bool ok = sort_data((Weft_Data *)buf->raw, len);
+	if (ok) {
+		arg[0] = new_seq(arg[0], (const Weft_Data *)buf->raw, len);
+	}
+	buf_free(buf);
+
+	return ok || eval_error(W, "sort: elements are not comparable");
+}
+
+static bool less_by(bool *less, void *ctx, Weft_Data left, Weft_Data right)
+{
+	Weft_BuiltinSortBy *by = ctx;
+	Weft_Data arg[2] = {left, right};
+	Weft_Data result;
+
+	if (!call_quote(by->W, "sort-by", by->fn, arg, 2, &result)) {
+		return false;
+	} else if (result.type != WEFT_DATA_INT) {
+		return type_error(by->W, "sort-by", result);
+	}
+
+	*less = result.inum;
+	return true;
+}
+
+static bool builtin_sort_by(Weft_EvalState *W)
+{
+	size_t len = 0;
+	if (!eval_require(W, 2, "sort-by")
+	    || !get_seq_len(&len, W, "sort-by", *eval_peek(W, 2))) {
+		return false;
+	}
+
+	Weft_BuiltinSortBy by = {W, eval_pop(W)};
+	Weft_Data seq = eval_pop(W);
+	Weft_Buf *buf = get_seq_data(seq, len);
+
+	bool ok = sort_data_by((Weft_Data *)buf->raw, len, less_by, &by);
+	if (ok) {
+		eval_push(W, new_seq(seq, (const Weft_Data *)buf->raw, len));
+	}
+	buf_free(buf);
+
+	return ok;
+}
+
+static bool builtin_fold(Weft_EvalState *W)
+{
+	size_t len = 0;
+	if (!eval_require(W, 3, "fold")
+	    || !get_seq_len(&len, W, "fold", *eval_peek(W, 3))) {
+		return false;
+	}
+
+	Weft_Data fn = eval_pop(W);
+	Weft_Data arg[2] = {eval_pop(W)};
+	Weft_Data seq = eval_pop(W);
+	const Weft_List *src = seq.ptr;
+
+	for (size_t i = 0; i < len; i++) {
+		arg[1] = next_item(seq, &src, i);
+		if (!call_quote(W, "fold", fn, arg, 2, &arg[0])) {
+			return false;
+		}
+	}
+
+	eval_push(W, arg[0]);
+	return true;
+}
+
+static bool apply_binary(Weft_EvalState *W,
+                         const char *name,
+                         bool (*binary)(Weft_EvalState *, Weft_Data *))
+{
+	if (!eval_require(W, 2, name) || !binary(W, eval_peek(W, 2))) {
+		return false;
+	}
+	eval_pop(W);
+
+	return true;
+}
+
+static bool check_int(Weft_EvalState *W, const char *name, Weft_Data data)
+{
+	return data.type == WEFT_DATA_INT || type_error(W, name, data);
+}
+
+static bool builtin_times(Weft_EvalState *W)
+{
+	if (!eval_require(W, 2, "times")
+	    || !check_int(W, "times", *eval_peek(W, 2))) {
+		return false;
+	}
+
+	Weft_Data fn = eval_pop(W);
+	long count = eval_pop(W).inum;
+
+	for (long i = 0; i < count; i++) {
+		if (!eval_apply(W, fn)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool binary_range(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (!check_int(W, "range", arg[0]) || !check_int(W, "range", arg[1])) {
+		return false;
+	}
+
+	long start = arg[0].inum;
+	size_t len = 0;
+	if (arg[1].inum > start) {
+		len = (unsigned long)arg[1].inum - (unsigned long)start;
+	}
+	if (len > vec_get_max_len(WEFT_VEC_I64)) {
+		return eval_error(W, "range: span of %zu is too large", len);
+	}
+
+	Weft_Vec *vec = new_vec(WEFT_VEC_I64, len);
+	for (size_t i = 0; i < len; i++) {
+		vec_set(vec, i, data_int(start + (long)i));
+	}
+
+	arg[0] = data_vec(vec);
+	return true;
+}
+
+static bool builtin_range(Weft_EvalState *W)
+{
+	return apply_binary(W, "range", binary_range);
+}
+
+static bool builtin_for_range(Weft_EvalState *W)
+{
+	if (!eval_require(W, 3, "for-range")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 3);
+	if (!check_int(W, "for-range", arg[0])
+	    || !check_int(W, "for-range", arg[1])) {
+		return false;
+	}
+
+	Weft_Data fn = eval_pop(W);
+	long end = eval_pop(W).inum;
+	long start = eval_pop(W).inum;
+
+	for (long i = start; i < end; i++) {
+		eval_push(W, data_int(i));
+		if (!eval_apply(W, fn)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool binary_cons(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[1].type != WEFT_DATA_LIST) {
+		return type_error(W, "cons", arg[1]);
+	}
+
+	arg[0] = data_list(new_list_node(arg[0], arg[1].ptr));
+	return true;
+}
+
+static bool builtin_cons(Weft_EvalState *W)
+{
+	return apply_binary(W, "cons", binary_cons);
+}
+
+static bool binary_cat(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type == WEFT_DATA_PVEC && arg[1].type == WEFT_DATA_PVEC) {
+		arg[0] = data_pvec(pvec_cat(arg[0].ptr, arg[1].ptr));
+		return true;
+	} else if (arg[0].type == WEFT_DATA_STR && arg[1].type == WEFT_DATA_STR) {
+		arg[0] = data_str(str_cat(arg[0].ptr, arg[1].ptr));
+		return true;
+	} else if (arg[0].type != WEFT_DATA_LIST) {
+		return type_error(W, "cat", arg[0]);
+	} else if (arg[1].type != WEFT_DATA_LIST) {
+		return type_error(W, "cat", arg[1]);
+	}
+
+	Weft_List *list = arg[1].ptr;
+	Weft_List *node = NULL;
+
+	for (const Weft_List *src = arg[0].ptr; src; src = src->cdr) {
+		Weft_List *next = new_list_node(src->car, arg[1].ptr);
+		if (node) {
+			node->cdr = next;
+		} else {
+			list = next;
+		}
+		node = next;
+	}
+
+	arg[0] = data_list(list);
+	return true;
+}
+
+static bool builtin_cat(Weft_EvalState *W)
+{
+	return apply_binary(W, "cat", binary_cat);
+}
+
+static bool is_number(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_INT:
+	case WEFT_DATA_FLOAT:
+	case WEFT_DATA_CHAR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static long get_inum(Weft_Data data)
+{
+	return (data.type == WEFT_DATA_CHAR) ? (long)data.cnum : data.inum;
+}
+
+static double get_fnum(Weft_Data data)
+{
+	return (data.type == WEFT_DATA_FLOAT) ? data.fnum : (double)get_inum(data);
+}
+
+static bool check_numbers(Weft_EvalState *W, const char *name, Weft_Data *arg)
+{
+	if (!is_number(arg[0])) {
+		return type_error(W, name, arg[0]);
+	} else if (!is_number(arg[1])) {
+		return type_error(W, name, arg[1]);
+	}
+	return true;
+}
+
+static bool has_vec(const Weft_Data *arg)
+{
+	return arg[0].type == WEFT_DATA_VEC || arg[1].type == WEFT_DATA_VEC;
+}
+
+static bool is_vec_operand(const Weft_Vec *vec, Weft_Data data)
+{
+	if (data.type == WEFT_DATA_VEC) {
+		return ((const Weft_Vec *)data.ptr)->type == vec->type;
+	}
+	return vec_accepts(vec->type, data);
+}
+
+static bool
+apply_vec(Weft_EvalState *W, const char *name, Weft_VecOp op, Weft_Data *arg)
+{
+	const Weft_Vec *vec = arg[0].ptr;
+	if (arg[0].type != WEFT_DATA_VEC) {
+		vec = arg[1].ptr;
+	}
+
+	if (!is_vec_operand(vec, arg[0])) {
+		return type_error(W, name, arg[0]);
+	} else if (!is_vec_operand(vec, arg[1])) {
+		return type_error(W, name, arg[1]);
+	} else if (arg[0].type == arg[1].type
+	           && vec->len != ((const Weft_Vec *)arg[1].ptr)->len) {
+		return eval_error(W,
+		                  "%s: length mismatch (%zu and %zu)",
+		                  name,
+		                  vec->len,
+		                  ((const Weft_Vec *)arg[1].ptr)->len);
+	} else if (op == WEFT_VEC_DIV && vec->type != WEFT_VEC_F64
+	           && vec_has_zero(arg[1])) {
+		return eval_error(W, "%s: division by zero", name);
+	} else if (op == WEFT_VEC_DIV && vec_has_overflow(arg[0], arg[1])) {
+		return eval_error(W, "%s: integer overflow", name);
+	}
+
+	arg[0] = data_vec(vec_apply(op, arg[0], arg[1]));
+	return true;
+}
+
+static bool is_float_pair(const Weft_Data *arg)
+{
+	return arg[0].type == WEFT_DATA_FLOAT || arg[1].type == WEFT_DATA_FLOAT;
+}
+
+static long int_add(long x, long y)
+{
+	return (long)((unsigned long)x + (unsigned long)y);
+}
+
+static long int_sub(long x, long y)
+{
+	return (long)((unsigned long)x - (unsigned long)y);
+}
+
+static long int_mul(long x, long y)
+{
+	return (long)((unsigned long)x * (unsigned long)y);
+}
+
+static bool check_div(Weft_EvalState *W, long x, long y)
+{
+	if (!y) {
+		return eval_error(W, "/: division by zero");
+	} else if (x == LONG_MIN && y == -1) {
+		return eval_error(W, "/: integer overflow");
+	}
+	return true;
+}
+
+static bool binary_add(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (has_vec(arg)) {
+		return apply_vec(W, "+", WEFT_VEC_ADD, arg);
+	} else if (!check_numbers(W, "+", arg)) {
+		return false;
+	} else if (is_float_pair(arg)) {
+		arg[0] = data_float(get_fnum(arg[0]) + get_fnum(arg[1]));
+	} else {
+		arg[0] = data_int(int_add(get_inum(arg[0]), get_inum(arg[1])));
+	}
+	return true;
+}
+
+static bool builtin_add(Weft_EvalState *W)
+{
+	return apply_binary(W, "+", binary_add);
+}
+
+static bool binary_sub(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (has_vec(arg)) {
+		return apply_vec(W, "-", WEFT_VEC_SUB, arg);
+	} else if (!check_numbers(W, "-", arg)) {
+		return false;
+	} else if (is_float_pair(arg)) {
+		arg[0] = data_float(get_fnum(arg[0]) - get_fnum(arg[1]));
+	} else {
+		arg[0] = data_int(int_sub(get_inum(arg[0]), get_inum(arg[1])));
+	}
+	return true;
+}
+
+static bool builtin_sub(Weft_EvalState *W)
+{
+	return apply_binary(W, "-", binary_sub);
+}
+
+static bool binary_mul(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (has_vec(arg)) {
+		return apply_vec(W, "*", WEFT_VEC_MUL, arg);
+	} else if (!check_numbers(W, "*", arg)) {
+		return false;
+	} else if (is_float_pair(arg)) {
+		arg[0] = data_float(get_fnum(arg[0]) * get_fnum(arg[1]));
+	} else {
+		arg[0] = data_int(int_mul(get_inum(arg[0]), get_inum(arg[1])));
+	}
+	return true;
+}
+
+static bool builtin_mul(Weft_EvalState *W)
+{
+	return apply_binary(W, "*", binary_mul);
+}
+
+static bool binary_div(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (has_vec(arg)) {
+		return apply_vec(W, "/", WEFT_VEC_DIV, arg);
+	} else if (!check_numbers(W, "/", arg)) {
+		return false;
+	} else if (is_float_pair(arg)) {
+		arg[0] = data_float(get_fnum(arg[0]) / get_fnum(arg[1]));
+	} else if (!check_div(W, get_inum(arg[0]), get_inum(arg[1]))) {
+		return false;
+	} else {
+		arg[0] = data_int(get_inum(arg[0]) / get_inum(arg[1]));
+	}
+	return true;
+}
+
+static bool builtin_div(Weft_EvalState *W)
+{
+	return apply_binary(W, "/", binary_div);
+}
+
+static bool binary_lt(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (has_vec(arg)) {
+		return apply_vec(W, "<", WEFT_VEC_LT, arg);
+	} else if (!check_numbers(W, "<", arg)) {
+		return false;
+	} else if (is_float_pair(arg)) {
+		arg[0] = data_int(get_fnum(arg[0]) < get_fnum(arg[1]));
+	} else {
+		arg[0] = data_int(get_inum(arg[0]) < get_inum(arg[1]));
+	}
+	return true;
+}
+
+static bool builtin_lt(Weft_EvalState *W)
+{
+	return apply_binary(W, "<", binary_lt);
+}
+
+static bool binary_eq(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (has_vec(arg)) {
+		return apply_vec(W, "=", WEFT_VEC_EQ, arg);
+	} else if (!check_numbers(W, "=", arg)) {
+		return false;
+	} else if (is_float_pair(arg)) {
+		arg[0] = data_int(get_fnum(arg[0]) == get_fnum(arg[1]));
+	} else {
+		arg[0] = data_int(get_inum(arg[0]) == get_inum(arg[1]));
+	}
+	return true;
+}
+
+static bool builtin_eq(Weft_EvalState *W)
+{
+	return apply_binary(W, "=", binary_eq);
+}
+
+static bool binary_add_int(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_INT || arg[1].type != WEFT_DATA_INT) {
+		return binary_add(W, arg);
+	}
+	arg[0] = data_int(int_add(arg[0].inum, arg[1].inum));
+	return true;
+}
+
+static bool builtin_add_int(Weft_EvalState *W)
+{
+	return apply_binary(W, "+", binary_add_int);
+}
+
+static bool binary_add_float(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_FLOAT || arg[1].type != WEFT_DATA_FLOAT) {
+		return binary_add(W, arg);
+	}
+	arg[0] = data_float(arg[0].fnum + arg[1].fnum);
+	return true;
+}
+
+static bool builtin_add_float(Weft_EvalState *W)
+{
+	return apply_binary(W, "+", binary_add_float);
+}
+
+static const Weft_BuiltinVariantDef add_variants = {
+	builtin_add_int,
+	binary_add_int,
+	builtin_add_float,
+	binary_add_float,
+};
+
+static bool binary_sub_int(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_INT || arg[1].type != WEFT_DATA_INT) {
+		return binary_sub(W, arg);
+	}
+	arg[0] = data_int(int_sub(arg[0].inum, arg[1].inum));
+	return true;
+}
+
+static bool builtin_sub_int(Weft_EvalState *W)
+{
+	return apply_binary(W, "-", binary_sub_int);
+}
+
+static bool binary_sub_float(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_FLOAT || arg[1].type != WEFT_DATA_FLOAT) {
+		return binary_sub(W, arg);
+	}
+	arg[0] = data_float(arg[0].fnum - arg[1].fnum);
+	return true;
+}
+
+static bool builtin_sub_float(Weft_EvalState *W)
+{
+	return apply_binary(W, "-", binary_sub_float);
+}
+
+static const Weft_BuiltinVariantDef sub_variants = {
+	builtin_sub_int,
+	binary_sub_int,
+	builtin_sub_float,
+	binary_sub_float,
+};
+
+static bool binary_mul_int(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_INT || arg[1].type != WEFT_DATA_INT) {
+		return binary_mul(W, arg);
+	}
+	arg[0] = data_int(int_mul(arg[0].inum, arg[1].inum));
+	return true;
+}
+
+static bool builtin_mul_int(Weft_EvalState *W)
+{
+	return apply_binary(W, "*", binary_mul_int);
+}
+
+static bool binary_mul_float(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_FLOAT || arg[1].type != WEFT_DATA_FLOAT) {
+		return binary_mul(W, arg);
+	}
+	arg[0] = data_float(arg[0].fnum * arg[1].fnum);
+	return true;
+}
+
+static bool builtin_mul_float(Weft_EvalState *W)
+{
+	return apply_binary(W, "*", binary_mul_float);
+}
+
+static const Weft_BuiltinVariantDef mul_variants = {
+	builtin_mul_int,
+	binary_mul_int,
+	builtin_mul_float,
+	binary_mul_float,
+};
+
+static bool binary_div_int(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_INT || arg[1].type != WEFT_DATA_INT) {
+		return binary_div(W, arg);
+	} else if (!check_div(W, arg[0].inum, arg[1].inum)) {
+		return false;
+	}
+	arg[0] = data_int(arg[0].inum / arg[1].inum);
+	return true;
+}
+
+static bool builtin_div_int(Weft_EvalState *W)
+{
+	return apply_binary(W, "/", binary_div_int);
+}
+
+static bool binary_div_float(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_FLOAT || arg[1].type != WEFT_DATA_FLOAT) {
+		return binary_div(W, arg);
+	}
+	arg[0] = data_float(arg[0].fnum / arg[1].fnum);
+	return true;
+}
+
+static bool builtin_div_float(Weft_EvalState *W)
+{
+	return apply_binary(W, "/", binary_div_float);
+}
+
+static const Weft_BuiltinVariantDef div_variants = {
+	builtin_div_int,
+	binary_div_int,
+	builtin_div_float,
+	binary_div_float,
+};
+
+static bool binary_lt_int(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_INT || arg[1].type != WEFT_DATA_INT) {
+		return binary_lt(W, arg);
+	}
+	arg[0] = data_int(arg[0].inum < arg[1].inum);
+	return true;
+}
+
+static bool builtin_lt_int(Weft_EvalState *W)
+{
+	return apply_binary(W, "<", binary_lt_int);
+}
+
+static bool binary_lt_float(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_FLOAT || arg[1].type != WEFT_DATA_FLOAT) {
+		return binary_lt(W, arg);
+	}
+	arg[0] = data_int(arg[0].fnum < arg[1].fnum);
+	return true;
+}
+
+static bool builtin_lt_float(Weft_EvalState *W)
+{
+	return apply_binary(W, "<", binary_lt_float);
+}
+
+static const Weft_BuiltinVariantDef lt_variants = {
+	builtin_lt_int,
+	binary_lt_int,
+	builtin_lt_float,
+	binary_lt_float,
+};
+
+static bool binary_eq_int(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_INT || arg[1].type != WEFT_DATA_INT) {
+		return binary_eq(W, arg);
+	}
+	arg[0] = data_int(arg[0].inum == arg[1].inum);
+	return true;
+}
+
+static bool builtin_eq_int(Weft_EvalState *W)
+{
+	return apply_binary(W, "=", binary_eq_int);
+}
+
+static bool binary_eq_float(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_FLOAT || arg[1].type != WEFT_DATA_FLOAT) {
+		return binary_eq(W, arg);
+	}
+	arg[0] = data_int(arg[0].fnum == arg[1].fnum);
+	return true;
+}
+
+static bool builtin_eq_float(Weft_EvalState *W)
+{
+	return apply_binary(W, "=", binary_eq_float);
+}
+
+static const Weft_BuiltinVariantDef eq_variants = {
+	builtin_eq_int,
+	binary_eq_int,
+	builtin_eq_float,
+	binary_eq_float,
+};
+
+static bool builtin_array(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "array")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	if (arg[0].type != WEFT_DATA_LIST) {
+		return type_error(W, "array", arg[0]);
+	}
+
+	arg[0] = data_array(array_from_list(arg[0].ptr));
+	return true;
+}
+
+static bool builtin_list(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "list")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	switch (arg[0].type) {
+	case WEFT_DATA_VEC:
+		arg[0] = data_list(vec_to_list(arg[0].ptr));
+		return true;
+	case WEFT_DATA_ARRAY:
+		arg[0] = data_list(array_to_list(arg[0].ptr));
+		return true;
+	case WEFT_DATA_PVEC:
+		arg[0] = data_list(pvec_to_list(arg[0].ptr));
+		return true;
+	case WEFT_DATA_DICT:
+		arg[0] = data_list(dict_to_list(arg[0].ptr));
+		return true;
+	default:
+		return type_error(W, "list", arg[0]);
+	}
+}
+
+static bool builtin_pvec(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "pvec")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	switch (arg[0].type) {
+	case WEFT_DATA_LIST:
+		arg[0] = data_pvec(pvec_from_list(arg[0].ptr));
+		return true;
+	case WEFT_DATA_ARRAY:
+		arg[0] = data_pvec(pvec_from_data(array_get_data(arg[0].ptr),
+		                                  array_get_len(arg[0].ptr)));
+		return true;
+	default:
+		return type_error(W, "pvec", arg[0]);
+	}
+}
+
+static bool to_vec(Weft_EvalState *W, const char *name, Weft_VecType type)
+{
+	if (!eval_require(W, 1, name)) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	const Weft_Data *data;
+	size_t len = 0;
+
+	switch (arg[0].type) {
+	case WEFT_DATA_STR:
+		if (type != WEFT_VEC_U32) {
+			return type_error(W, name, arg[0]);
+		}
+		arg[0] = data_vec(vec_from_str(arg[0].ptr));
+		return true;
+	case WEFT_DATA_ARRAY:
+		data = array_get_data(arg[0].ptr);
+		len = array_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_LIST:
+		for (const Weft_List *list = arg[0].ptr; list; list = list->cdr) {
+			if (!vec_accepts(type, list->car)) {
+				return type_error(W, name, list->car);
+			}
+			len++;
+		}
+
+		Weft_Vec *vec = new_vec(type, len);
+		len = 0;
+		for (const Weft_List *list = arg[0].ptr; list; list = list->cdr) {
+			vec_set(vec, len++, list->car);
+		}
+		arg[0] = data_vec(vec);
+		return true;
+	default:
+		return type_error(W, name, arg[0]);
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		if (!vec_accepts(type, data[i])) {
+			return type_error(W, name, data[i]);
+		}
+	}
+	arg[0] = data_vec(vec_from_data(type, data, len));
+	return true;
+}
+
+static bool builtin_ivec(Weft_EvalState *W)
+{
+	return to_vec(W, "ivec", WEFT_VEC_I64);
+}
+
+static bool builtin_fvec(Weft_EvalState *W)
+{
+	return to_vec(W, "fvec", WEFT_VEC_F64);
+}
+
+static bool builtin_cvec(Weft_EvalState *W)
+{
+	return to_vec(W, "cvec", WEFT_VEC_U32);
+}
+
+static bool builtin_len(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "len")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	size_t len = 0;
+
+	switch (arg[0].type) {
+	case WEFT_DATA_ARRAY:
+		len = array_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_VEC:
+		len = ((const Weft_Vec *)arg[0].ptr)->len;
+		break;
+	case WEFT_DATA_PVEC:
+		len = pvec_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_DICT:
+		len = dict_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_LIST:
+		for (const Weft_List *list = arg[0].ptr; list; list = list->cdr) {
+			len++;
+		}
+		break;
+	case WEFT_DATA_STR:
+		len = ((const Weft_Str *)arg[0].ptr)->len;
+		break;
+	default:
+		return type_error(W, "len", arg[0]);
+	}
+
+	arg[0] = data_int(len);
+	return true;
+}
+
+static long
+get_index(Weft_EvalState *W, const char *name, Weft_Data data, size_t limit)
+{
+	if (data.type != WEFT_DATA_INT) {
+		type_error(W, name, data);
+		return -1;
+	} else if (data.inum < 0 || (size_t)data.inum > limit) {
+		eval_error(W, "%s: index %ld out of range", name, data.inum);
+		return -1;
+	}
+	return data.inum;
+}
+
+static bool binary_nth(Weft_EvalState *W, Weft_Data *arg)
+{
+	size_t len;
+	switch (arg[0].type) {
+	case WEFT_DATA_ARRAY:
+		len = array_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_VEC:
+		len = ((const Weft_Vec *)arg[0].ptr)->len;
+		break;
+	case WEFT_DATA_PVEC:
+		len = pvec_get_len(arg[0].ptr);
+		break;
+	default:
+		return type_error(W, "nth", arg[0]);
+	}
+
+	if (!len) {
+		return eval_error(W, "nth: sequence is empty");
+	}
+
+	long index = get_index(W, "nth", arg[1], len - 1);
+	if (index < 0) {
+		return false;
+	}
+
+	switch (arg[0].type) {
+	case WEFT_DATA_VEC:
+		arg[0] = vec_get(arg[0].ptr, index);
+		break;
+	case WEFT_DATA_PVEC:
+		arg[0] = pvec_get(arg[0].ptr, index);
+		break;
+	default:
+		arg[0] = array_get(arg[0].ptr, index);
+		break;
+	}
+	return true;
+}
+
+static bool builtin_nth(Weft_EvalState *W)
+{
+	return apply_binary(W, "nth", binary_nth);
+}
+
+static bool builtin_slice(Weft_EvalState *W)
+{
+	if (!eval_require(W, 3, "slice")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 3);
+	size_t len;
+	switch (arg[0].type) {
+	case WEFT_DATA_ARRAY:
+		len = array_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_PVEC:
+		len = pvec_get_len(arg[0].ptr);
+		break;
+	case WEFT_DATA_STR:
+		len = ((const Weft_Str *)arg[0].ptr)->len;
+		break;
+	default:
+		return type_error(W, "slice", arg[0]);
+	}
+
+	long start = get_index(W, "slice", arg[1], len);
+	if (start < 0) {
+		return false;
+	}
+
+	long end = get_index(W, "slice", arg[2], len);
+	if (end < 0) {
+		return false;
+	} else if (start > end) {
+		return eval_error(W, "slice: start %ld after end %ld", start, end);
+	}
+
+	switch (arg[0].type) {
+	case WEFT_DATA_PVEC:
+		arg[0] = data_pvec(pvec_slice(arg[0].ptr, start, end));
+		break;
+	case WEFT_DATA_STR:
+		arg[0] = data_str(str_slice(arg[0].ptr, start, end));
+		break;
+	default:
+		arg[0] = data_array(array_slice(arg[0].ptr, start, end));
+		break;
+	}
+	eval_pop(W);
+	eval_pop(W);
+
+	return true;
+}
+
+static bool binary_push(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type == WEFT_DATA_PVEC) {
+		arg[0] = data_pvec(pvec_push(arg[0].ptr, arg[1]));
+		return true;
+	} else if (arg[0].type != WEFT_DATA_ARRAY) {
+		return type_error(W, "push", arg[0]);
+	}
+
+	arg[0] = data_array(array_push(arg[0].ptr, arg[1]));
+	return true;
+}
+
+static bool builtin_push(Weft_EvalState *W)
+{
+	return apply_binary(W, "push", binary_push);
+}
+
+static bool builtin_set(Weft_EvalState *W)
+{
+	if (!eval_require(W, 3, "set")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 3);
+	if (arg[0].type != WEFT_DATA_PVEC) {
+		return type_error(W, "set", arg[0]);
+	} else if (!pvec_get_len(arg[0].ptr)) {
+		return eval_error(W, "set: sequence is empty");
+	}
+
+	long index =
+		get_index(W, "set", arg[1], pvec_get_len(arg[0].ptr) - 1);
+	if (index < 0) {
+		return false;
+	}
+
+	arg[0] = data_pvec(pvec_set(arg[0].ptr, index, arg[2]));
+	eval_pop(W);
+	eval_pop(W);
+
+	return true;
+}
+
+static bool builtin_split(Weft_EvalState *W)
+{
+	if (!eval_require(W, 2, "split")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 2);
+	if (arg[0].type == WEFT_DATA_STR) {
+		const Weft_Str *str = arg[0].ptr;
+		long index = get_index(W, "split", arg[1], str->len);
+		if (index < 0) {
+			return false;
+		}
+
+		arg[0] = data_str(str_slice(str, 0, index));
+		arg[1] = data_str(str_slice(str, index, str->len));
+		return true;
+	} else if (arg[0].type != WEFT_DATA_PVEC) {
+		return type_error(W, "split", arg[0]);
+	}
+
+	const Weft_PVec *pvec = arg[0].ptr;
+	size_t len = pvec_get_len(pvec);
+	long index = get_index(W, "split", arg[1], len);
+	if (index < 0) {
+		return false;
+	}
+
+	arg[0] = data_pvec(pvec_slice(pvec, 0, index));
+	arg[1] = data_pvec(pvec_slice(pvec, index, len));
+
+	return true;
+}
+
+static bool is_pair(Weft_Data data)
+{
+	if (data.type != WEFT_DATA_LIST) {
+		return false;
+	}
+
+	const Weft_List *list = data.ptr;
+	return list && list->cdr && !list->cdr->cdr;
+}
+
+static bool builtin_dict(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "dict")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	if (arg[0].type != WEFT_DATA_LIST) {
+		return type_error(W, "dict", arg[0]);
+	}
+
+	for (const Weft_List *list = arg[0].ptr; list; list = list->cdr) {
+		if (!is_pair(list->car)) {
+			return type_error(W, "dict", list->car);
+		}
+	}
+
+	arg[0] = data_dict(dict_from_list(arg[0].ptr));
+	return true;
+}
+
+static bool binary_get(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_DICT) {
+		return type_error(W, "get", arg[0]);
+	} else if (!dict_get(&arg[0], arg[0].ptr, arg[1])) {
+		return eval_error(W, "get: key not found");
+	}
+	return true;
+}
+
+static bool builtin_get(Weft_EvalState *W)
+{
+	return apply_binary(W, "get", binary_get);
+}
+
+static bool binary_has(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_DICT) {
+		return type_error(W, "has", arg[0]);
+	}
+
+	Weft_Data value;
+	arg[0] = data_int(dict_get(&value, arg[0].ptr, arg[1]));
+	return true;
+}
+
+static bool builtin_has(Weft_EvalState *W)
+{
+	return apply_binary(W, "has", binary_has);
+}
+
+static bool builtin_put(Weft_EvalState *W)
+{
+	if (!eval_require(W, 3, "put")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 3);
+	if (arg[0].type != WEFT_DATA_DICT) {
+		return type_error(W, "put", arg[0]);
+	}
+
+	arg[0] = data_dict(dict_put(arg[0].ptr, arg[1], arg[2]));
+	eval_pop(W);
+	eval_pop(W);
+
+	return true;
+}
+
+static bool binary_del(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_DICT) {
+		return type_error(W, "del", arg[0]);
+	}
+
+	arg[0] = data_dict(dict_del(arg[0].ptr, arg[1]));
+	return true;
+}
+
+static bool builtin_del(Weft_EvalState *W)
+{
+	return apply_binary(W, "del", binary_del);
+}
+
+static bool builtin_keys(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "keys")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	if (arg[0].type != WEFT_DATA_DICT) {
+		return type_error(W, "keys", arg[0]);
+	}
+
+	arg[0] = data_list(dict_keys(arg[0].ptr));
+	return true;
+}
+
+static bool builtin_values(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "values")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	if (arg[0].type != WEFT_DATA_DICT) {
+		return type_error(W, "values", arg[0]);
+	}
+
+	arg[0] = data_list(dict_values(arg[0].ptr));
+	return true;
+}
+
+static bool is_field_end(const Weft_Str *str,
+                         size_t index,
+                         const char *sep,
+                         size_t width)
+{
+	return index + width <= str->len
+	    && !memcmp(str_get_ch(str) + index, sep, width);
+}
+
+static bool binary_fields(Weft_EvalState *W, Weft_Data *arg)
+{
+	if (arg[0].type != WEFT_DATA_STR) {
+		return type_error(W, "fields", arg[0]);
+	} else if (arg[1].type != WEFT_DATA_CHAR) {
+		return type_error(W, "fields", arg[1]);
+	}
+
+	char sep[4];
+	size_t width = char_write(sep, arg[1].cnum) - sep;
+
+	const Weft_Str *str = arg[0].ptr;
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+	size_t start = 0;
+
+	for (size_t i = 0; i <= str->len; i++) {
+		if (i < str->len && !is_field_end(str, i, sep, width)) {
+			continue;
+		}
+
+		Weft_Data field = data_str(str_slice(str, start, i));
+		Weft_List *next = new_list_node(field, NULL);
+		if (node) {
+			node->cdr = next;
+		} else {
+			list = next;
+		}
+		node = next;
+
+		i += width - 1;
+		start = i + 1;
+	}
+
+	arg[0] = data_list(list);
+	return true;
+}
+
+static bool builtin_fields(Weft_EvalState *W)
+{
+	return apply_binary(W, "fields", binary_fields);
+}
+
+static const Weft_Vec *
+get_vec(Weft_EvalState *W, const char *name, Weft_Data data, bool nonempty)
+{
+	if (data.type != WEFT_DATA_VEC) {
+		type_error(W, name, data);
+		return NULL;
+	} else if (nonempty && !((const Weft_Vec *)data.ptr)->len) {
+		eval_error(W, "%s: vector is empty", name);
+		return NULL;
+	}
+	return data.ptr;
+}
+
+static bool reduce(Weft_EvalState *W,
+                   const char *name,
+                   bool nonempty,
+                   Weft_Data (*fn)(const Weft_Vec *))
+{
+	if (!eval_require(W, 1, name)) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	const Weft_Vec *vec = get_vec(W, name, arg[0], nonempty);
+	if (!vec) {
+		return false;
+	}
+
+	arg[0] = fn(vec);
+	return true;
+}
+
+static bool builtin_sum(Weft_EvalState *W)
+{
+	return reduce(W, "sum", false, vec_sum);
+}
+
+static bool builtin_min(Weft_EvalState *W)
+{
+	return reduce(W, "min", true, vec_min);
+}
+
+static bool builtin_max(Weft_EvalState *W)
+{
+	return reduce(W, "max", true, vec_max);
+}
+
+static bool binary_dot(Weft_EvalState *W, Weft_Data *arg)
+{
+	const Weft_Vec *left = get_vec(W, "dot", arg[0], false);
+	const Weft_Vec *right = left ? get_vec(W, "dot", arg[1], false) : NULL;
+
+	if (!right) {
+		return false;
+	} else if (left->type != right->type) {
+		return type_error(W, "dot", arg[1]);
+	} else if (left->len != right->len) {
+		return eval_error(W,
+		                  "dot: length mismatch (%zu and %zu)",
+		                  left->len,
+		                  right->len);
+	}
+
+	arg[0] = vec_dot(left, right);
+	return true;
+}
+
+static bool builtin_dot(Weft_EvalState *W)
+{
+	return apply_binary(W, "dot", binary_dot);
+}
+
+static bool builtin_scan(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "scan")) {
+		return false;
+	}
+
+	Weft_Data *arg = eval_peek(W, 1);
+	const Weft_Vec *vec = get_vec(W, "scan", arg[0], false);
+	if (!vec) {
+		return false;
+	}
+
+	arg[0] = data_vec(vec_scan(vec));
+	return true;
+}
+
+static bool builtin_print_data(Weft_EvalState *W)
+{
+	if (!eval_require(W, 1, "print")) {
+		return false;
+	}
+
+	Weft_Data data = eval_pop(W);
+	if (data.type == WEFT_DATA_STR) {
+		str_print_bare(data.ptr);
+	} else {
+		data_print(data);
+	}
+	printf("\n");
+
+	return true;
+}
+
+static const Weft_BuiltinDef builtin_def[] = {
+	{"eval", builtin_eval, NULL, NULL, true, false, 1, 0},
+	{"memo", builtin_memo, NULL, NULL, false, false, 1, 0},
+	{"map", builtin_map_seq, NULL, NULL, false, true, 2, 1},
+	{"filter", builtin_filter, NULL, NULL, false, true, 2, 1},
+	{"fold", builtin_fold, NULL, NULL, false, true, 3, 1},
+	{"times", builtin_times, NULL, NULL, false, false, 2, 0},
+	{"range", builtin_range, binary_range, NULL, false, true, 2, 1},
+	{"for-range", builtin_for_range, NULL, NULL, false, false, 3, 0},
+	{"pmap", builtin_pmap, NULL, NULL, false, true, 2, 1},
+	{"sort", builtin_sort, NULL, NULL, true, true, 1, 1},
+	{"sort-by", builtin_sort_by, NULL, NULL, false, true, 2, 1},
+	{"cons", builtin_cons, binary_cons, NULL, true, true, 2, 1},
+	{"cat", builtin_cat, binary_cat, NULL, true, true, 2, 1},
+	{"+", builtin_add, binary_add, &add_variants, true, true, 2, 1},
+	{"-", builtin_sub, binary_sub, &sub_variants, true, true, 2, 1},
+	{"*", builtin_mul, binary_mul, &mul_variants, true, true, 2, 1},
+	{"/", builtin_div, binary_div, &div_variants, true, true, 2, 1},
+	{"<", builtin_lt, binary_lt, &lt_variants, true, true, 2, 1},
+	{"=", builtin_eq, binary_eq, &eq_variants, true, true, 2, 1},
+	{"array", builtin_array, NULL, NULL, true, true, 1, 1},
+	{"list", builtin_list, NULL, NULL, true, true, 1, 1},
+	{"len", builtin_len, NULL, NULL, true, true, 1, 1},
+	{"nth", builtin_nth, binary_nth, NULL, true, true, 2, 1},
+	{"slice", builtin_slice, NULL, NULL, true, true, 3, 1},
+	{"push", builtin_push, binary_push, NULL, true, true, 2, 1},
+	{"pvec", builtin_pvec, NULL, NULL, true, true, 1, 1},
+	{"set", builtin_set, NULL, NULL, true, true, 3, 1},
+	{"split", builtin_split, NULL, NULL, true, true, 2, 2},
+	{"fields", builtin_fields, binary_fields, NULL, true, true, 2, 1},
+	{"dict", builtin_dict, NULL, NULL, true, true, 1, 1},
+	{"get", builtin_get, binary_get, NULL, true, true, 2, 1},
+	{"has", builtin_has, binary_has, NULL, true, true, 2, 1},
+	{"put", builtin_put, NULL, NULL, true, true, 3, 1},
+	{"del", builtin_del, binary_del, NULL, true, true, 2, 1},
+	{"keys", builtin_keys, NULL, NULL, true, true, 1, 1},
+	{"values", builtin_values, NULL, NULL, true, true, 1, 1},
+	{"ivec", builtin_ivec, NULL, NULL, true, true, 1, 1},
+	{"fvec", builtin_fvec, NULL, NULL, true, true, 1, 1},
+	{"cvec", builtin_cvec, NULL, NULL, true, true, 1, 1},
+	{"sum", builtin_sum, NULL, NULL, true, true, 1, 1},
+	{"min", builtin_min, NULL, NULL, true, true, 1, 1},
+	{"max", builtin_max, NULL, NULL, true, true, 1, 1},
+	{"dot", builtin_dot, binary_dot, NULL, true, true, 2, 1},
+	{"scan", builtin_scan, NULL, NULL, true, true, 1, 1},
+	{"print", builtin_print_data, NULL, NULL, false, true, 1, 0},
+};
+
+static Weft_Builtin *
+new_variant(const Weft_Builtin *builtin,
+            bool (*fn)(Weft_EvalState *),
+            bool (*binary)(Weft_EvalState *, Weft_Data *))
+{
+	Weft_Builtin *variant =
+		new_builtin_n(builtin->name, strlen(builtin->name), fn);
+	variant->binary = binary;
+	variant->pure = builtin->pure;
+	variant->effect = builtin->effect;
+
+	return variant;
+}
+
+Weft_Map *builtin_get_map(void)
+{
+	if (builtin_map) {
+		return builtin_map;
+	}
+
+	for (size_t i = 0; i < sizeof(builtin_def) / sizeof(*builtin_def); i++) {
+		const Weft_BuiltinDef *def = &builtin_def[i];
+
+		Weft_Builtin *builtin =
+			new_builtin_n(def->name, strlen(def->name), def->fn);
+		builtin->binary = def->binary;
+		builtin->pure = def->pure;
+		builtin->effect = def->known ? effect_known(def->in, def->out)
+		                             : effect_unknown(def->in);
+
+		if (def->variants) {
+			builtin->int_variant = new_variant(builtin,
+			                                   def->variants->int_fn,
+			                                   def->variants->int_binary);
+			builtin->float_variant = new_variant(builtin,
+			                                     def->variants->float_fn,
+			                                     def->variants->float_binary);
+		}
+
+		builtin_map =
+			map_insert(builtin_map, new_map_key_builtin(builtin_map, builtin));
+	}
+	return builtin_map;
+}
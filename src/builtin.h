@@ -7,12 +7,22 @@
 // Forward Declarations
 
 typedef struct weft_eval_state Weft_EvalState;
+typedef struct weft_map Weft_Map;
 typedef struct weft_builtin Weft_Builtin;
 
+// Local Includes
+
+#include "effect.h"
+
 // Data Types
 
 struct weft_builtin {
 	bool (*fn)(Weft_EvalState *);
+	bool (*binary)(Weft_EvalState *, Weft_Data *);
+	Weft_Builtin *int_variant;
+	Weft_Builtin *float_variant;
+	bool pure;
+	Weft_Effect effect;
 	char name[];
 };
 
@@ -20,6 +30,9 @@ struct weft_builtin {
 
 Weft_Builtin *
 new_builtin_n(const char *name, size_t name_len, bool (*fn)(Weft_EvalState *));
+void builtin_mark(Weft_Builtin *builtin);
+Weft_Builtin *builtin_specialize(Weft_Builtin *builtin, const Weft_Data *arg);
 void builtin_print(const Weft_Builtin *builtin);
+Weft_Map *builtin_get_map(void);
 
 #endif
@@ -0,0 +1,113 @@
+#include "cache.h"
+#include "fold.h"
+#include "image.h"
+#include "inline.h"
+#include "intern.h"
+#include "lower.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Constants
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Functions
+
+static uint64_t hash_bytes(uint64_t hash, const void *src, size_t len)
+{
+	const unsigned char *byte = src;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= byte[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static uint64_t hash_options(uint64_t hash)
+{
+	unsigned limit[] = {
+		inline_get_limit(),
+		fold_get_limit(),
+		lower_get_limit(),
+		intern_is_enabled(),
+	};
+	return hash_bytes(hash, limit, sizeof(limit));
+}
+
+static uint64_t hash_src(const char *src)
+{
+	uint64_t hash = FNV_OFFSET;
+	hash = hash_bytes(hash, WEFT_VERSION, sizeof(WEFT_VERSION));
+	hash = hash_bytes(hash, &WEFT_IMAGE_VERSION, sizeof(WEFT_IMAGE_VERSION));
+	hash = hash_options(hash);
+	return hash_bytes(hash, src, strlen(src));
+}
+
+static bool get_cache_path(char *path, const char *dir, const char *src)
+{
+	int len = snprintf(path,
+	                   PATH_MAX,
+	                   "%s/%016llx.weftc",
+	                   dir,
+	                   (unsigned long long)hash_src(src));
+	return len > 0 && len < PATH_MAX;
+}
+
+bool cache_load(Weft_List **ctrl_p,
+                Weft_Map **map_p,
+                Weft_Map *builtins,
+                const char *dir,
+                const char *src)
+{
+	char path[PATH_MAX];
+	if (!get_cache_path(path, dir, src) || access(path, R_OK)) {
+		return false;
+	}
+	return image_load(ctrl_p, map_p, builtins, path);
+}
+
+bool cache_store(const char *dir,
+                 const char *src,
+                 Weft_List *ctrl,
+                 Weft_Map *map)
+{
+	char path[PATH_MAX];
+	char temp[PATH_MAX];
+	if (!get_cache_path(path, dir, src)) {
+		return false;
+	}
+
+	int len = snprintf(temp, PATH_MAX, "%s.%ld.tmp", path, (long)getpid());
+	if (len <= 0 || len >= PATH_MAX) {
+		return false;
+	}
+
+	if (mkdir(dir, 0777) && errno != EEXIST) {
+		fprintf(stderr,
+		        "Failed to create cache directory '%s': %s\n",
+		        dir,
+		        strerror(errno));
+		return false;
+	}
+
+	if (!image_save(temp, ctrl, map)) {
+		unlink(temp);
+		return false;
+	} else if (rename(temp, path)) {
+		fprintf(stderr,
+		        "Failed to rename '%s' to '%s': %s\n",
+		        temp,
+		        path,
+		        strerror(errno));
+		unlink(temp);
+		return false;
+	}
+	return true;
+}
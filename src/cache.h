@@ -0,0 +1,28 @@
+#ifndef WEFT_CACHE_H
+#define WEFT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_map Weft_Map;
+
+// Constants
+
+static const char WEFT_VERSION[] = "0.1";
+
+// Functions
+
+bool cache_load(Weft_List **ctrl_p,
+                Weft_Map **map_p,
+                Weft_Map *builtins,
+                const char *dir,
+                const char *src);
+bool cache_store(const char *dir,
+                 const char *src,
+                 Weft_List *ctrl,
+                 Weft_Map *map);
+
+#endif
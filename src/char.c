@@ -147,17 +147,17 @@ uint32_t char_read_n(const char *src, unsigned width)
 	case 1:
 		return src[0];
 	case 2:
-		return (((uint32_t)src[0] & ~UTF8_2MASK) << UTF8_SHIFT)
-		     | ((uint32_t)src[1] & ~UTF8_XMASK);
+		return (((uint8_t)src[0] & ~UTF8_2MASK) << UTF8_SHIFT)
+		     | ((uint8_t)src[1] & ~UTF8_XMASK);
 	case 3:
-		return (((uint32_t)src[0] & ~UTF8_3MASK) << (2 * UTF8_SHIFT))
-		     | (((uint32_t)src[1] & ~UTF8_XMASK) << UTF8_SHIFT)
-		     | ((uint32_t)src[2] & ~UTF8_XMASK);
+		return (((uint8_t)src[0] & ~UTF8_3MASK) << (2 * UTF8_SHIFT))
+		     | (((uint8_t)src[1] & ~UTF8_XMASK) << UTF8_SHIFT)
+		     | ((uint8_t)src[2] & ~UTF8_XMASK);
 	case 4:
-		return (((uint32_t)src[0] & ~UTF8_4MASK) << (3 * UTF8_SHIFT))
-		     | (((uint32_t)src[1] & ~UTF8_XMASK) << (2 * UTF8_SHIFT))
-		     | (((uint32_t)src[2] & ~UTF8_XMASK) << UTF8_SHIFT)
-		     | ((uint32_t)src[3] & ~UTF8_XMASK);
+		return (((uint8_t)src[0] & ~UTF8_4MASK) << (3 * UTF8_SHIFT))
+		     | (((uint8_t)src[1] & ~UTF8_XMASK) << (2 * UTF8_SHIFT))
+		     | (((uint8_t)src[2] & ~UTF8_XMASK) << UTF8_SHIFT)
+		     | ((uint8_t)src[3] & ~UTF8_XMASK);
 	default:
 		return 0;
 	}
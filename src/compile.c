@@ -1,7 +1,11 @@
 #include "compile.h"
 #include "buf.h"
+#include "builtin.h"
 #include "data.h"
 #include "fn.h"
+#include "fold.h"
+#include "inline.h"
+#include "intern.h"
 #include "list.h"
 #include "map.h"
 #include "parse.h"
@@ -10,12 +14,14 @@
 
 void compile_init(Weft_CompileState *C)
 {
-	C->map = NULL;
+	C->map = builtin_get_map();
+	C->lazy = true;
 
 	C->list = NULL;
 	C->list_stack = new_buf(sizeof(Weft_List *));
 	C->node = NULL;
 	C->node_stack = new_buf(sizeof(Weft_List *));
+	C->src_stack = new_buf(sizeof(Weft_ParseList *));
 }
 
 void compile_exit(Weft_CompileState *C)
@@ -26,6 +32,7 @@ void compile_exit(Weft_CompileState *C)
 	C->list_stack = buf_free(C->list_stack);
 	C->node = NULL;
 	C->node_stack = buf_free(C->node_stack);
+	C->src_stack = buf_free(C->src_stack);
 }
 
 static void output_data(Weft_CompileState *C, Weft_Data data)
@@ -57,18 +64,43 @@ static Weft_Data strip_token(Weft_ParseToken token)
 	}
 }
 
-static void handle_block(Weft_CompileState *C, Weft_ParseBlock *block)
+static Weft_List *
+compile_body(Weft_Map *map, bool lazy, Weft_ParseBlock *block)
 {
 	Weft_CompileState temp;
 	compile_init(&temp);
-	temp.map = C->map;
+	temp.map = map;
+	temp.lazy = lazy;
 
 	Weft_List *body = compile(&temp, block->body);
-	Weft_MapKey *key = new_map_key_fn(
-		temp.map, new_fn_n(block->head.src, block->head.len, body));
-	C->map = map_insert(C->map, key);
-
 	compile_exit(&temp);
+
+	return body;
+}
+
+static unsigned get_body_len(const Weft_ParseBlock *block)
+{
+	unsigned len = 0;
+	for (const Weft_ParseList *body = block->body; body; body = body->cdr) {
+		len++;
+	}
+	return len;
+}
+
+static void handle_block(Weft_CompileState *C, Weft_ParseBlock *block)
+{
+	Weft_Fn *fn;
+	if (C->lazy) {
+		fn = new_fn_stub_n(block->head.src, block->head.len, block, C->map);
+	} else {
+		fn = new_fn_n(block->head.src,
+		              block->head.len,
+		              compile_body(C->map, false, block));
+	}
+	fn->len = get_body_len(block);
+
+	Weft_MapKey *key = new_map_key_fn(C->map, fn);
+	C->map = map_insert(C->map, key);
 }
 
 static void handle_lookup(Weft_CompileState *C, Weft_ParseToken token)
@@ -95,12 +127,12 @@ Weft_List *compile(Weft_CompileState *C, Weft_ParseList *src)
 				handle_lookup(C, token);
 				break;
 			case WEFT_PARSE_LIST:
-				C->list_stack =
-					buf_push(C->list_stack, &C->list, sizeof(Weft_List *));
+				C->list_stack = buf_push_ptr(C->list_stack, C->list);
 				C->list = NULL;
-				C->node_stack =
-					buf_push(C->node_stack, &C->node, sizeof(Weft_List *));
+				C->node_stack = buf_push_ptr(C->node_stack, C->node);
 				C->node = NULL;
+				C->src_stack = buf_push_ptr(C->src_stack, src);
+				src = token.ptr;
 				break;
 			case WEFT_PARSE_BLOCK:
 				handle_block(C, token.ptr);
@@ -113,13 +145,22 @@ Weft_List *compile(Weft_CompileState *C, Weft_ParseList *src)
 
 		while (buf_get_at(C->list_stack) && !src) {
 			Weft_List *list = C->list;
-			C->list_stack =
-				buf_pop(&C->list, C->list_stack, sizeof(Weft_List *));
-			C->node_stack =
-				buf_pop(&C->node, C->node_stack, sizeof(Weft_List *));
+			C->list_stack = buf_pop_ptr(&C->list, C->list_stack);
+			C->node_stack = buf_pop_ptr(&C->node, C->node_stack);
+			C->src_stack = buf_pop_ptr(&src, C->src_stack);
 			output_data(C, data_list(list));
 		}
 	} while (src);
 
-	return C->list;
+	return intern_list(fold_list(inline_list(C->list)));
+}
+
+Weft_List *compile_fn(Weft_Fn *fn)
+{
+	if (fn_is_stub(fn)) {
+		fn->list = compile_body(fn->map, true, fn->block);
+		fn->block = NULL;
+		fn->map = NULL;
+	}
+	return fn->list;
 }
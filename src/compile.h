@@ -1,9 +1,12 @@
 #ifndef WEFT_COMPILE_H
 #define WEFT_COMPILE_H
 
+#include <stdbool.h>
+
 // Forward Declarations
 
 typedef struct weft_buf Weft_Buf;
+typedef struct weft_fn Weft_Fn;
 typedef struct weft_list Weft_List;
 typedef struct weft_parse_list Weft_ParseList;
 typedef struct weft_map Weft_Map;
@@ -13,11 +16,13 @@ typedef struct weft_compile_state Weft_CompileState;
 
 struct weft_compile_state {
 	Weft_Map *map;
+	bool lazy;
 
 	Weft_List *list;
 	Weft_Buf *list_stack;
 	Weft_List *node;
 	Weft_Buf *node_stack;
+	Weft_Buf *src_stack;
 };
 
 // Functions
@@ -25,5 +30,6 @@ struct weft_compile_state {
 void compile_init(Weft_CompileState *C);
 void compile_exit(Weft_CompileState *C);
 Weft_List *compile(Weft_CompileState *C, Weft_ParseList *list);
+Weft_List *compile_fn(Weft_Fn *fn);
 
 #endif
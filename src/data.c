@@ -1,12 +1,18 @@
 #include "data.h"
+#include "array.h"
 #include "builtin.h"
 #include "char.h"
+#include "dict.h"
 #include "fn.h"
+#include "frame.h"
 #include "list.h"
+#include "pvec.h"
 #include "shuffle.h"
 #include "str.h"
+#include "vec.h"
 
 #include <stdio.h>
+#include <string.h>
 
 static Weft_Data tag_ptr(Weft_DataType type, void *ptr)
 {
@@ -74,6 +80,288 @@ Weft_Data data_fn(Weft_Fn *fn)
 	return tag_ptr(WEFT_DATA_FN, fn);
 }
 
+Weft_Data data_array(Weft_Array *array)
+{
+	return tag_ptr(WEFT_DATA_ARRAY, array);
+}
+
+Weft_Data data_vec(Weft_Vec *vec)
+{
+	return tag_ptr(WEFT_DATA_VEC, vec);
+}
+
+Weft_Data data_pvec(Weft_PVec *pvec)
+{
+	return tag_ptr(WEFT_DATA_PVEC, pvec);
+}
+
+Weft_Data data_dict(Weft_Dict *dict)
+{
+	return tag_ptr(WEFT_DATA_DICT, dict);
+}
+
+Weft_Data data_frame(Weft_Frame *frame)
+{
+	return tag_ptr(WEFT_DATA_FRAME, frame);
+}
+
+static uint64_t mix_hash(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static uint64_t combine_hash(uint64_t hash, uint64_t next)
+{
+	return mix_hash(hash * 0x9e3779b97f4a7c15ULL + next);
+}
+
+static uint64_t get_float_bits(double fnum)
+{
+	if (fnum == 0) {
+		fnum = 0;
+	}
+
+	uint64_t bits;
+	memcpy(&bits, &fnum, sizeof(bits));
+	return bits;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const char *ch, size_t len)
+{
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, ch + i, sizeof(word));
+		hash = combine_hash(hash, word);
+	}
+
+	uint64_t tail = 0;
+	memcpy(&tail, ch + i, len - i);
+	return combine_hash(hash, tail ^ len);
+}
+
+static uint64_t hash_name(uint64_t hash, const char *name)
+{
+	return hash_bytes(hash, name, strlen(name));
+}
+
+static uint64_t hash_shuffle(uint64_t hash, const Weft_Shuffle *shuffle)
+{
+	hash = combine_hash(hash, shuffle_get_in_count(shuffle));
+	for (unsigned i = 0; i < shuffle_get_out_count(shuffle); i++) {
+		hash = combine_hash(hash, shuffle_get_out(shuffle, i));
+	}
+	return hash;
+}
+
+static uint64_t hash_pvec(uint64_t hash, const Weft_PVec *pvec)
+{
+	for (size_t i = 0; i < pvec_get_len(pvec);) {
+		size_t len;
+		const Weft_Data *data = pvec_get_chunk(pvec, i, &len);
+
+		for (size_t j = 0; j < len; j++) {
+			hash = combine_hash(hash, data_hash(data[j]));
+		}
+		i += len;
+	}
+	return hash;
+}
+
+static uint64_t hash_dict(uint64_t hash, const Weft_Dict *dict)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < dict_get_cap(dict); i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			sum += combine_hash(data_hash(entry->key),
+			                    data_hash(entry->value));
+		}
+	}
+	return combine_hash(hash, sum);
+}
+
+uint64_t data_hash(Weft_Data data)
+{
+	uint64_t hash = data.type;
+
+	switch (data.type) {
+	case WEFT_DATA_NIL:
+		return mix_hash(hash);
+	case WEFT_DATA_INT:
+		return combine_hash(hash, data.inum);
+	case WEFT_DATA_FLOAT:
+		return combine_hash(hash, get_float_bits(data.fnum));
+	case WEFT_DATA_CHAR:
+		return combine_hash(hash, data.cnum);
+	case WEFT_DATA_STR: {
+		const Weft_Str *str = data.ptr;
+		return hash_bytes(hash, str_get_ch(str), str->len);
+	}
+	case WEFT_DATA_SHUFFLE:
+		return hash_shuffle(hash, data.ptr);
+	case WEFT_DATA_BUILTIN:
+		return hash_name(hash, ((const Weft_Builtin *)data.ptr)->name);
+	case WEFT_DATA_FN:
+		return hash_name(hash, ((const Weft_Fn *)data.ptr)->name);
+	case WEFT_DATA_LIST:
+		for (const Weft_List *list = data.ptr; list; list = list->cdr) {
+			hash = combine_hash(hash, data_hash(list->car));
+		}
+		return hash;
+	case WEFT_DATA_ARRAY:
+		for (size_t i = 0; i < array_get_len(data.ptr); i++) {
+			hash = combine_hash(hash, data_hash(array_get(data.ptr, i)));
+		}
+		return hash;
+	case WEFT_DATA_VEC:
+		for (size_t i = 0; i < ((const Weft_Vec *)data.ptr)->len; i++) {
+			hash = combine_hash(hash, data_hash(vec_get(data.ptr, i)));
+		}
+		return hash;
+	case WEFT_DATA_PVEC:
+		return hash_pvec(hash, data.ptr);
+	case WEFT_DATA_DICT:
+		return hash_dict(hash, data.ptr);
+	default:
+		return combine_hash(hash, (uintptr_t)data.ptr);
+	}
+}
+
+uint64_t data_hash_combine(uint64_t hash, uint64_t next)
+{
+	return combine_hash(hash, next);
+}
+
+static bool str_equal(const Weft_Str *left, const Weft_Str *right)
+{
+	return left->len == right->len
+	    && !memcmp(str_get_ch(left), str_get_ch(right), left->len);
+}
+
+static bool list_equal(const Weft_List *left, const Weft_List *right)
+{
+	for (; left && right; left = left->cdr, right = right->cdr) {
+		if (left == right) {
+			return true;
+		} else if (!data_equal(left->car, right->car)) {
+			return false;
+		}
+	}
+	return left == right;
+}
+
+static bool array_equal(const Weft_Array *left, const Weft_Array *right)
+{
+	if (array_get_len(left) != array_get_len(right)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < array_get_len(left); i++) {
+		if (!data_equal(array_get(left, i), array_get(right, i))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool vec_equal(const Weft_Vec *left, const Weft_Vec *right)
+{
+	if (left->type != right->type || left->len != right->len) {
+		return false;
+	}
+
+	for (size_t i = 0; i < left->len; i++) {
+		if (!data_equal(vec_get(left, i), vec_get(right, i))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool pvec_equal(const Weft_PVec *left, const Weft_PVec *right)
+{
+	if (pvec_get_len(left) != pvec_get_len(right)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < pvec_get_len(left); i++) {
+		if (!data_equal(pvec_get(left, i), pvec_get(right, i))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool dict_equal(const Weft_Dict *left, const Weft_Dict *right)
+{
+	if (dict_get_len(left) != dict_get_len(right)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < dict_get_cap(left); i++) {
+		const Weft_DictEntry *entry = dict_get_entry(left, i);
+		Weft_Data value;
+
+		if (!entry) {
+			continue;
+		} else if (!dict_get(&value, right, entry->key)
+		           || !data_equal(entry->value, value)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool data_equal(Weft_Data left, Weft_Data right)
+{
+	if (left.type != right.type) {
+		return false;
+	}
+
+	switch (left.type) {
+	case WEFT_DATA_NIL:
+		return true;
+	case WEFT_DATA_INT:
+		return left.inum == right.inum;
+	case WEFT_DATA_FLOAT:
+		return get_float_bits(left.fnum) == get_float_bits(right.fnum);
+	case WEFT_DATA_CHAR:
+		return left.cnum == right.cnum;
+	default:
+		break;
+	}
+
+	if (left.ptr == right.ptr) {
+		return true;
+	}
+
+	switch (left.type) {
+	case WEFT_DATA_STR:
+		return str_equal(left.ptr, right.ptr);
+	case WEFT_DATA_BUILTIN:
+		return !strcmp(((const Weft_Builtin *)left.ptr)->name,
+		               ((const Weft_Builtin *)right.ptr)->name);
+	case WEFT_DATA_LIST:
+		return list_equal(left.ptr, right.ptr);
+	case WEFT_DATA_ARRAY:
+		return array_equal(left.ptr, right.ptr);
+	case WEFT_DATA_VEC:
+		return vec_equal(left.ptr, right.ptr);
+	case WEFT_DATA_PVEC:
+		return pvec_equal(left.ptr, right.ptr);
+	case WEFT_DATA_DICT:
+		return dict_equal(left.ptr, right.ptr);
+	default:
+		return false;
+	}
+}
+
 void data_print(const Weft_Data data)
 {
 	switch (data.type) {
@@ -104,6 +392,21 @@ void data_print(const Weft_Data data)
 	case WEFT_DATA_FN:
 		fn_print(data.ptr);
 		break;
+	case WEFT_DATA_ARRAY:
+		array_print(data.ptr);
+		break;
+	case WEFT_DATA_VEC:
+		vec_print(data.ptr);
+		break;
+	case WEFT_DATA_PVEC:
+		pvec_print(data.ptr);
+		break;
+	case WEFT_DATA_DICT:
+		dict_print(data.ptr);
+		break;
+	case WEFT_DATA_FRAME:
+		frame_print(data.ptr);
+		break;
 	default:
 		printf("%u:%p", data.type, data.ptr);
 		break;
@@ -1,6 +1,7 @@
 #ifndef WEFT_DATA_H
 #define WEFT_DATA_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 // Forward Declarations
@@ -10,6 +11,11 @@ typedef struct weft_shuffle Weft_Shuffle;
 typedef struct weft_list Weft_List;
 typedef struct weft_builtin Weft_Builtin;
 typedef struct weft_fn Weft_Fn;
+typedef struct weft_array Weft_Array;
+typedef struct weft_vec Weft_Vec;
+typedef struct weft_pvec Weft_PVec;
+typedef struct weft_dict Weft_Dict;
+typedef struct weft_frame Weft_Frame;
 typedef enum weft_data_type Weft_DataType;
 typedef struct weft_data Weft_Data;
 
@@ -25,6 +31,11 @@ enum weft_data_type {
 	WEFT_DATA_LIST,
 	WEFT_DATA_BUILTIN,
 	WEFT_DATA_FN,
+	WEFT_DATA_ARRAY,
+	WEFT_DATA_VEC,
+	WEFT_DATA_PVEC,
+	WEFT_DATA_DICT,
+	WEFT_DATA_FRAME,
 };
 
 struct weft_data {
@@ -48,6 +59,14 @@ Weft_Data data_shuffle(Weft_Shuffle *shuffle);
 Weft_Data data_list(Weft_List *list);
 Weft_Data data_builtin(Weft_Builtin *builtin);
 Weft_Data data_fn(Weft_Fn *fn);
+Weft_Data data_array(Weft_Array *array);
+Weft_Data data_vec(Weft_Vec *vec);
+Weft_Data data_pvec(Weft_PVec *pvec);
+Weft_Data data_dict(Weft_Dict *dict);
+Weft_Data data_frame(Weft_Frame *frame);
+uint64_t data_hash(Weft_Data data);
+uint64_t data_hash_combine(uint64_t hash, uint64_t next);
+bool data_equal(Weft_Data left, Weft_Data right);
 void data_print(const Weft_Data data);
 
 #endif
@@ -0,0 +1,353 @@
+#include "dict.h"
+#include "gc.h"
+#include "list.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#define WEFT_DICT_SSE2
+#include <emmintrin.h>
+#endif
+
+// Functions
+
+static size_t get_cap(size_t count)
+{
+	size_t cap = WEFT_DICT_GROUP;
+	while (cap - cap / 8 < count) {
+		cap *= 2;
+	}
+	return cap;
+}
+
+static size_t get_room(size_t cap)
+{
+	return cap - cap / 8;
+}
+
+static Weft_DictEntry *get_entries(const Weft_DictBuf *buf)
+{
+	return (Weft_DictEntry *)(buf->ctrl + buf->cap + WEFT_DICT_GROUP);
+}
+
+static uint8_t get_tag(uint64_t hash)
+{
+	return hash >> 57;
+}
+
+static unsigned match_byte(const uint8_t *ctrl, uint8_t byte)
+{
+#if defined(WEFT_DICT_SSE2)
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+#else
+	unsigned bits = 0;
+	for (unsigned i = 0; i < WEFT_DICT_GROUP; i++) {
+		bits |= (unsigned)(ctrl[i] == byte) << i;
+	}
+	return bits;
+#endif
+}
+
+static size_t find_slot(const Weft_DictBuf *buf,
+                        size_t count,
+                        Weft_Data key,
+                        uint64_t hash,
+                        bool *found)
+{
+	const Weft_DictEntry *entry = get_entries(buf);
+	uint8_t tag = get_tag(hash);
+	size_t mask = buf->cap - 1;
+	size_t pos = hash & mask;
+
+	for (size_t stride = WEFT_DICT_GROUP;; stride += WEFT_DICT_GROUP) {
+		const uint8_t *group = buf->ctrl + pos;
+
+		for (unsigned bits = match_byte(group, tag); bits; bits &= bits - 1) {
+			size_t slot = (pos + __builtin_ctz(bits)) & mask;
+			if (entry[slot].seq < count
+			    && data_equal(entry[slot].key, key)) {
+				*found = true;
+				return slot;
+			}
+		}
+
+		unsigned empty = match_byte(group, WEFT_DICT_EMPTY);
+		if (empty) {
+			*found = false;
+			return (pos + __builtin_ctz(empty)) & mask;
+		}
+		pos = (pos + stride) & mask;
+	}
+}
+
+static void set_ctrl(Weft_DictBuf *buf, size_t slot, uint8_t tag)
+{
+	buf->ctrl[slot] = tag;
+	if (slot < WEFT_DICT_GROUP) {
+		buf->ctrl[buf->cap + slot] = tag;
+	}
+}
+
+size_t dict_buf_get_size(size_t cap)
+{
+	return sizeof(Weft_DictBuf) + cap + WEFT_DICT_GROUP
+	     + cap * sizeof(Weft_DictEntry);
+}
+
+static Weft_DictBuf *new_dict_buf(size_t cap)
+{
+	Weft_DictBuf *buf = gc_alloc(dict_buf_get_size(cap));
+	buf->len = 0;
+	buf->room = get_room(cap);
+	buf->cap = cap;
+	memset(buf->ctrl, WEFT_DICT_EMPTY, cap + WEFT_DICT_GROUP);
+	memset(get_entries(buf), 0, cap * sizeof(Weft_DictEntry));
+
+	return buf;
+}
+
+static Weft_Dict *new_view(Weft_DictBuf *buf, size_t count)
+{
+	Weft_Dict *dict = gc_alloc(sizeof(Weft_Dict));
+	dict->buf = buf;
+	dict->count = count;
+
+	return dict;
+}
+
+Weft_Dict *new_dict(size_t count)
+{
+	return new_view(new_dict_buf(get_cap(count)), 0);
+}
+
+static void
+insert_new(Weft_DictBuf *buf, Weft_Data key, Weft_Data value, uint64_t hash)
+{
+	bool found;
+	size_t slot = find_slot(buf, buf->len, key, hash, &found);
+
+	Weft_DictEntry *entry = get_entries(buf) + slot;
+	entry->key = key;
+	entry->value = value;
+
+	if (!found) {
+		entry->seq = buf->len++;
+		set_ctrl(buf, slot, get_tag(hash));
+	}
+}
+
+static bool is_tip(const Weft_Dict *dict)
+{
+	return dict->count == dict->buf->len && dict->buf->len < dict->buf->room;
+}
+
+static Weft_Dict *copy_dict(const Weft_Dict *dict, size_t count)
+{
+	const Weft_DictBuf *buf = dict->buf;
+
+	if (dict->count == buf->len && get_cap(count) <= buf->cap) {
+		Weft_DictBuf *copy = gc_alloc(dict_buf_get_size(buf->cap));
+		memcpy(copy, buf, dict_buf_get_size(buf->cap));
+		copy->room = get_room(copy->cap);
+		return new_view(copy, copy->len);
+	}
+
+	Weft_DictBuf *copy = new_dict_buf(get_cap(count));
+	for (size_t i = 0; i < buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			insert_new(copy, entry->key, entry->value, data_hash(entry->key));
+		}
+	}
+	return new_view(copy, copy->len);
+}
+
+Weft_Dict *dict_insert(Weft_Dict *dict, Weft_Data key, Weft_Data value)
+{
+	if (!is_tip(dict)) {
+		dict = copy_dict(dict, dict->count + 1);
+	}
+
+	insert_new(dict->buf, key, value, data_hash(key));
+	dict->count = dict->buf->len;
+	return dict;
+}
+
+Weft_Dict *dict_from_list(const Weft_List *list)
+{
+	size_t count = 0;
+	for (const Weft_List *node = list; node; node = node->cdr) {
+		count++;
+	}
+
+	Weft_Dict *dict = new_dict(count);
+	for (; list; list = list->cdr) {
+		const Weft_List *pair = list->car.ptr;
+		dict = dict_insert(dict, pair->car, pair->cdr->car);
+	}
+	return dict;
+}
+
+static Weft_List *
+push_node(Weft_List **list_p, Weft_List *node, Weft_Data data)
+{
+	Weft_List *next = new_list_node(data, NULL);
+	if (node) {
+		node->cdr = next;
+	} else {
+		*list_p = next;
+	}
+	return next;
+}
+
+Weft_List *dict_to_list(const Weft_Dict *dict)
+{
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+
+	for (size_t i = 0; i < dict->buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			Weft_List *pair = new_list_node(
+				entry->key, new_list_node(entry->value, NULL));
+			node = push_node(&list, node, data_list(pair));
+		}
+	}
+	return list;
+}
+
+Weft_List *dict_keys(const Weft_Dict *dict)
+{
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+
+	for (size_t i = 0; i < dict->buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			node = push_node(&list, node, entry->key);
+		}
+	}
+	return list;
+}
+
+Weft_List *dict_values(const Weft_Dict *dict)
+{
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+
+	for (size_t i = 0; i < dict->buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			node = push_node(&list, node, entry->value);
+		}
+	}
+	return list;
+}
+
+const Weft_DictEntry *dict_buf_get_entry(const Weft_DictBuf *buf, size_t slot)
+{
+	if (buf->ctrl[slot] == WEFT_DICT_EMPTY) {
+		return NULL;
+	}
+	return get_entries(buf) + slot;
+}
+
+size_t dict_get_len(const Weft_Dict *dict)
+{
+	return dict->count;
+}
+
+size_t dict_get_cap(const Weft_Dict *dict)
+{
+	return dict->buf->cap;
+}
+
+const Weft_DictEntry *dict_get_entry(const Weft_Dict *dict, size_t slot)
+{
+	const Weft_DictEntry *entry = dict_buf_get_entry(dict->buf, slot);
+	if (!entry || entry->seq >= dict->count) {
+		return NULL;
+	}
+	return entry;
+}
+
+bool dict_get(Weft_Data *dest, const Weft_Dict *dict, Weft_Data key)
+{
+	bool found;
+	size_t slot =
+		find_slot(dict->buf, dict->count, key, data_hash(key), &found);
+
+	if (found) {
+		*dest = get_entries(dict->buf)[slot].value;
+	}
+	return found;
+}
+
+Weft_Dict *dict_put(const Weft_Dict *dict, Weft_Data key, Weft_Data value)
+{
+	bool found;
+	uint64_t hash = data_hash(key);
+	find_slot(dict->buf, dict->count, key, hash, &found);
+
+	if (found || !is_tip(dict)) {
+		Weft_Dict *copy = copy_dict(dict, dict->count + !found);
+		insert_new(copy->buf, key, value, hash);
+		copy->count = copy->buf->len;
+		return copy;
+	}
+
+	insert_new(dict->buf, key, value, hash);
+	return new_view(dict->buf, dict->buf->len);
+}
+
+Weft_Dict *dict_del(const Weft_Dict *dict, Weft_Data key)
+{
+	bool found;
+	uint64_t hash = data_hash(key);
+	size_t skip = find_slot(dict->buf, dict->count, key, hash, &found);
+
+	if (!found) {
+		return (Weft_Dict *)dict;
+	}
+
+	Weft_DictBuf *copy = new_dict_buf(get_cap(dict->count - 1));
+	for (size_t i = 0; i < dict->buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (i != skip && entry) {
+			insert_new(copy, entry->key, entry->value, data_hash(entry->key));
+		}
+	}
+	return new_view(copy, copy->len);
+}
+
+void dict_seal(Weft_Dict *dict)
+{
+	if (dict->buf->room != dict->buf->len) {
+		dict->buf->room = dict->buf->len;
+	}
+}
+
+void dict_print(const Weft_Dict *dict)
+{
+	bool first = true;
+
+	printf("#d[");
+	for (size_t i = 0; i < dict->buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (!entry) {
+			continue;
+		} else if (!first) {
+			printf(" ");
+		}
+		first = false;
+
+		printf("[");
+		data_print(entry->key);
+		printf(" ");
+		data_print(entry->value);
+		printf("]");
+	}
+	printf("]");
+}
@@ -0,0 +1,63 @@
+#ifndef WEFT_DICT_H
+#define WEFT_DICT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_dict_entry Weft_DictEntry;
+typedef struct weft_dict_buf Weft_DictBuf;
+typedef struct weft_dict Weft_Dict;
+
+// Local Includes
+
+#include "data.h"
+
+// Data Types
+
+struct weft_dict_entry {
+	Weft_Data key;
+	Weft_Data value;
+	size_t seq;
+};
+
+struct weft_dict_buf {
+	size_t len;
+	size_t room;
+	size_t cap;
+	uint8_t ctrl[];
+};
+
+struct weft_dict {
+	Weft_DictBuf *buf;
+	size_t count;
+};
+
+// Constants
+
+static const size_t WEFT_DICT_GROUP = 16;
+static const uint8_t WEFT_DICT_EMPTY = 0x80;
+
+// Functions
+
+Weft_Dict *new_dict(size_t count);
+Weft_Dict *dict_from_list(const Weft_List *list);
+Weft_List *dict_to_list(const Weft_Dict *dict);
+Weft_List *dict_keys(const Weft_Dict *dict);
+Weft_List *dict_values(const Weft_Dict *dict);
+size_t dict_buf_get_size(size_t cap);
+const Weft_DictEntry *dict_buf_get_entry(const Weft_DictBuf *buf, size_t slot);
+size_t dict_get_len(const Weft_Dict *dict);
+size_t dict_get_cap(const Weft_Dict *dict);
+const Weft_DictEntry *dict_get_entry(const Weft_Dict *dict, size_t slot);
+bool dict_get(Weft_Data *dest, const Weft_Dict *dict, Weft_Data key);
+Weft_Dict *dict_insert(Weft_Dict *dict, Weft_Data key, Weft_Data value);
+Weft_Dict *dict_put(const Weft_Dict *dict, Weft_Data key, Weft_Data value);
+Weft_Dict *dict_del(const Weft_Dict *dict, Weft_Data key);
+void dict_seal(Weft_Dict *dict);
+void dict_print(const Weft_Dict *dict);
+
+#endif
@@ -0,0 +1,140 @@
+#include "effect.h"
+#include "builtin.h"
+#include "compile.h"
+#include "fn.h"
+#include "frame.h"
+#include "list.h"
+#include "shuffle.h"
+
+#include <stdio.h>
+
+// Constants
+
+#define FMT_ERROR "\e[91m"
+#define FMT_RESET "\e[0m"
+
+// Functions
+
+Weft_Effect effect_known(unsigned in, unsigned out)
+{
+	Weft_Effect effect = {
+		.state = WEFT_EFFECT_KNOWN,
+		.in = in,
+		.out = out,
+	};
+	return effect;
+}
+
+bool effect_is_known(Weft_Effect effect)
+{
+	return effect.state == WEFT_EFFECT_KNOWN;
+}
+
+Weft_Effect effect_unknown(unsigned in)
+{
+	Weft_Effect effect = {
+		.state = WEFT_EFFECT_UNKNOWN,
+		.in = in,
+		.out = 0,
+	};
+	return effect;
+}
+
+Weft_Effect effect_then(Weft_Effect first, Weft_Effect second)
+{
+	if (!effect_is_known(first)) {
+		return first;
+	}
+
+	unsigned in = first.in;
+	unsigned height = first.out;
+
+	if (height < second.in) {
+		in += second.in - height;
+		height = second.in;
+	}
+
+	if (!effect_is_known(second)) {
+		return effect_unknown(in);
+	}
+	return effect_known(in, height - second.in + second.out);
+}
+
+Weft_Effect effect_of_data(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_SHUFFLE: {
+		const Weft_Shuffle *shuffle = data.ptr;
+		return effect_known(shuffle_get_in_count(shuffle),
+		                    shuffle_get_out_count(shuffle));
+	}
+	case WEFT_DATA_BUILTIN:
+		return ((const Weft_Builtin *)data.ptr)->effect;
+	case WEFT_DATA_FN:
+		return effect_of_fn(data.ptr);
+	case WEFT_DATA_FRAME: {
+		const Weft_Frame *frame = data.ptr;
+		return effect_known(frame->in_count, frame->out_count);
+	}
+	default:
+		return effect_known(0, 1);
+	}
+}
+
+Weft_Effect effect_of_list(const Weft_List *list)
+{
+	Weft_Effect effect = effect_known(0, 0);
+
+	for (; list && effect_is_known(effect); list = list->cdr) {
+		effect = effect_then(effect, effect_of_data(list->car));
+	}
+	return effect;
+}
+
+Weft_Effect effect_of_fn(Weft_Fn *fn)
+{
+	switch (fn->effect.state) {
+	case WEFT_EFFECT_PENDING:
+		fn->effect.state = WEFT_EFFECT_ACTIVE;
+		fn->effect = effect_of_list(compile_fn(fn));
+		return fn->effect;
+	case WEFT_EFFECT_ACTIVE:
+		return effect_unknown(0);
+	default:
+		return fn->effect;
+	}
+}
+
+static const char *get_op_name(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_BUILTIN:
+		return ((const Weft_Builtin *)data.ptr)->name;
+	case WEFT_DATA_FN:
+		return ((const Weft_Fn *)data.ptr)->name;
+	default:
+		return "shuffle";
+	}
+}
+
+bool effect_check(const Weft_List *ctrl)
+{
+	Weft_Effect effect = effect_known(0, 0);
+
+	for (; ctrl; ctrl = ctrl->cdr) {
+		Weft_Effect next = effect_then(effect, effect_of_data(ctrl->car));
+		if (next.in) {
+			fprintf(stderr,
+			        FMT_ERROR "error: " FMT_RESET
+			        "%s: stack underflow (need %u, have %u)\n",
+			        get_op_name(ctrl->car),
+			        next.in + effect.out,
+			        effect.out);
+			return false;
+		} else if (!effect_is_known(next)) {
+			return true;
+		}
+		effect = next;
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+#ifndef WEFT_EFFECT_H
+#define WEFT_EFFECT_H
+
+#include <stdbool.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_fn Weft_Fn;
+typedef enum weft_effect_state Weft_EffectState;
+typedef struct weft_effect Weft_Effect;
+
+// Data Types
+
+enum weft_effect_state {
+	WEFT_EFFECT_PENDING,
+	WEFT_EFFECT_ACTIVE,
+	WEFT_EFFECT_KNOWN,
+	WEFT_EFFECT_UNKNOWN,
+};
+
+struct weft_effect {
+	Weft_EffectState state;
+	unsigned in;
+	unsigned out;
+};
+
+// Local Includes
+
+#include "data.h"
+
+// Functions
+
+Weft_Effect effect_known(unsigned in, unsigned out);
+Weft_Effect effect_unknown(unsigned in);
+bool effect_is_known(Weft_Effect effect);
+Weft_Effect effect_then(Weft_Effect first, Weft_Effect second);
+Weft_Effect effect_of_data(Weft_Data data);
+Weft_Effect effect_of_list(const Weft_List *list);
+Weft_Effect effect_of_fn(Weft_Fn *fn);
+bool effect_check(const Weft_List *ctrl);
+
+#endif
@@ -0,0 +1,615 @@
+#include "emit.h"
+#include "array.h"
+#include "buf.h"
+#include "builtin.h"
+#include "compile.h"
+#include "data.h"
+#include "dict.h"
+#include "effect.h"
+#include "file.h"
+#include "fn.h"
+#include "list.h"
+#include "pvec.h"
+#include "shuffle.h"
+#include "str.h"
+#include "table.h"
+#include "vec.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Forward Declarations
+
+typedef struct weft_emit_state Weft_EmitState;
+
+// Data Types
+
+struct weft_emit_state {
+	FILE *f;
+	Weft_Table *ids;
+	Weft_Buf *builtins;
+	Weft_Buf *fns;
+	Weft_Buf *strs;
+	Weft_Buf *shuffles;
+	Weft_Buf *cells;
+	Weft_Buf *arrays;
+	Weft_Buf *vecs;
+	Weft_Buf *pvecs;
+	Weft_Buf *dicts;
+	Weft_Buf *order;
+	Weft_Buf *pending;
+};
+
+// Functions
+
+static size_t get_count(const Weft_Buf *buf)
+{
+	return buf_get_at(buf) / sizeof(void *);
+}
+
+static void *get_item(const Weft_Buf *buf, size_t index)
+{
+	void *const *items = buf_peek(buf, buf_get_at(buf));
+	return items[index];
+}
+
+static size_t get_id(const Weft_EmitState *E, const void *ptr)
+{
+	size_t id = 0;
+	table_lookup(&id, E->ids, ptr);
+
+	return id;
+}
+
+static bool add_item(Weft_EmitState *E, Weft_Buf **items_p, void *ptr)
+{
+	size_t id;
+	if (table_lookup(&id, E->ids, ptr)) {
+		return false;
+	}
+
+	E->ids = table_insert(E->ids, ptr, get_count(*items_p));
+	*items_p = buf_push(*items_p, &ptr, sizeof(ptr));
+
+	return true;
+}
+
+static void collect_list(Weft_EmitState *E, Weft_List *list);
+static void collect_array(Weft_EmitState *E, Weft_Array *array);
+static void collect_pvec(Weft_EmitState *E, Weft_PVec *pvec);
+static void collect_dict(Weft_EmitState *E, Weft_Dict *dict);
+
+static void collect_data(Weft_EmitState *E, Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_STR:
+		add_item(E, &E->strs, data.ptr);
+		break;
+	case WEFT_DATA_SHUFFLE:
+		add_item(E, &E->shuffles, data.ptr);
+		break;
+	case WEFT_DATA_LIST:
+		collect_list(E, data.ptr);
+		break;
+	case WEFT_DATA_BUILTIN:
+		add_item(E, &E->builtins, data.ptr);
+		break;
+	case WEFT_DATA_FN:
+		if (add_item(E, &E->fns, data.ptr)) {
+			E->pending = buf_push(E->pending, &data.ptr, sizeof(data.ptr));
+		}
+		break;
+	case WEFT_DATA_ARRAY:
+		collect_array(E, data.ptr);
+		break;
+	case WEFT_DATA_VEC:
+		add_item(E, &E->vecs, data.ptr);
+		break;
+	case WEFT_DATA_PVEC:
+		collect_pvec(E, data.ptr);
+		break;
+	case WEFT_DATA_DICT:
+		collect_dict(E, data.ptr);
+		break;
+	default:
+		break;
+	}
+}
+
+static void collect_array(Weft_EmitState *E, Weft_Array *array)
+{
+	size_t id;
+	if (table_lookup(&id, E->ids, array)) {
+		return;
+	}
+
+	const Weft_Data *data = array_get_data(array);
+	for (size_t i = 0; i < array_get_len(array); i++) {
+		collect_data(E, data[i]);
+	}
+	add_item(E, &E->arrays, array);
+	E->order = buf_push_data(E->order, data_array(array));
+}
+
+static void collect_pvec(Weft_EmitState *E, Weft_PVec *pvec)
+{
+	size_t id;
+	if (table_lookup(&id, E->ids, pvec)) {
+		return;
+	}
+
+	for (size_t i = 0; i < pvec_get_len(pvec); i++) {
+		collect_data(E, pvec_get(pvec, i));
+	}
+	add_item(E, &E->pvecs, pvec);
+	E->order = buf_push_data(E->order, data_pvec(pvec));
+}
+
+static void collect_dict(Weft_EmitState *E, Weft_Dict *dict)
+{
+	size_t id;
+	if (table_lookup(&id, E->ids, dict)) {
+		return;
+	}
+
+	for (size_t i = 0; i < dict_get_cap(dict); i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			collect_data(E, entry->key);
+			collect_data(E, entry->value);
+		}
+	}
+	add_item(E, &E->dicts, dict);
+	E->order = buf_push_data(E->order, data_dict(dict));
+}
+
+static void collect_list(Weft_EmitState *E, Weft_List *list)
+{
+	Weft_Buf *chain = new_buf(16 * sizeof(Weft_List *));
+
+	for (size_t id; list && !table_lookup(&id, E->ids, list);) {
+		chain = buf_push(chain, &list, sizeof(list));
+		list = list->cdr;
+	}
+
+	while (buf_get_at(chain)) {
+		chain = buf_pop(&list, chain, sizeof(list));
+		collect_data(E, list->car);
+		add_item(E, &E->cells, list);
+		E->order = buf_push_data(E->order, data_list(list));
+	}
+	buf_free(chain);
+}
+
+static void collect(Weft_EmitState *E, Weft_List *ctrl)
+{
+	collect_list(E, ctrl);
+
+	while (buf_get_at(E->pending)) {
+		Weft_Fn *fn;
+		E->pending = buf_pop(&fn, E->pending, sizeof(fn));
+		collect_list(E, compile_fn(fn));
+	}
+}
+
+static void emit_bytes(FILE *f, const char *src, size_t len)
+{
+	fputc('"', f);
+	for (size_t i = 0; i < len; i++) {
+		unsigned char c = src[i];
+		if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '?') {
+			fputc(c, f);
+		} else {
+			fprintf(f, "\\%03o", c);
+		}
+	}
+	fputc('"', f);
+}
+
+static void emit_list_ref(const Weft_EmitState *E, const Weft_List *list)
+{
+	if (list) {
+		fprintf(E->f, "cell[%zu]", get_id(E, list));
+	} else {
+		fprintf(E->f, "NULL");
+	}
+}
+
+static void emit_float(FILE *f, double fnum)
+{
+	if (isnan(fnum)) {
+		fprintf(f, "NAN");
+	} else if (isinf(fnum)) {
+		fprintf(f, fnum < 0 ? "-INFINITY" : "INFINITY");
+	} else {
+		fprintf(f, "%a", fnum);
+	}
+}
+
+static void emit_data(const Weft_EmitState *E, Weft_Data data)
+{
+	FILE *f = E->f;
+
+	switch (data.type) {
+	case WEFT_DATA_INT:
+		if (data.inum == LONG_MIN) {
+			fprintf(f, "data_int(LONG_MIN)");
+		} else {
+			fprintf(f, "data_int(%ldL)", data.inum);
+		}
+		break;
+	case WEFT_DATA_FLOAT:
+		fprintf(f, "data_float(");
+		emit_float(f, data.fnum);
+		fprintf(f, ")");
+		break;
+	case WEFT_DATA_CHAR:
+		fprintf(f, "data_char(%uu)", data.cnum);
+		break;
+	case WEFT_DATA_STR:
+		fprintf(f, "data_str(str[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_SHUFFLE:
+		fprintf(f, "data_shuffle(shuffle[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_LIST:
+		fprintf(f, "data_list(");
+		emit_list_ref(E, data.ptr);
+		fprintf(f, ")");
+		break;
+	case WEFT_DATA_BUILTIN:
+		fprintf(f, "data_builtin(builtin[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_FN:
+		fprintf(f, "data_fn(fn[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_ARRAY:
+		fprintf(f, "data_array(array[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_VEC:
+		fprintf(f, "data_vec(vec[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_PVEC:
+		fprintf(f, "data_pvec(pvec[%zu])", get_id(E, data.ptr));
+		break;
+	case WEFT_DATA_DICT:
+		fprintf(f, "data_dict(dict[%zu])", get_id(E, data.ptr));
+		break;
+	default:
+		fprintf(f, "data_nil()");
+		break;
+	}
+}
+
+static void
+emit_array(FILE *f, const char *type, const char *name, size_t count)
+{
+	if (count) {
+		fprintf(f, "static %s *%s[%zu];\n", type, name, count);
+	}
+}
+
+static void emit_prelude(const Weft_EmitState *E)
+{
+	FILE *f = E->f;
+
+	fprintf(f,
+	        "#include \"array.h\"\n"
+	        "#include \"builtin.h\"\n"
+	        "#include \"data.h\"\n"
+	        "#include \"dict.h\"\n"
+	        "#include \"eval.h\"\n"
+	        "#include \"fn.h\"\n"
+	        "#include \"list.h\"\n"
+	        "#include \"map.h\"\n"
+	        "#include \"pvec.h\"\n"
+	        "#include \"shuffle.h\"\n"
+	        "#include \"str.h\"\n"
+	        "#include \"vec.h\"\n"
+	        "\n"
+	        "#include <limits.h>\n"
+	        "#include <math.h>\n"
+	        "#include <stdbool.h>\n"
+	        "#include <stddef.h>\n"
+	        "#include <string.h>\n"
+	        "\n");
+
+	emit_array(f, "Weft_Builtin", "builtin", get_count(E->builtins));
+	emit_array(f, "Weft_Fn", "fn", get_count(E->fns));
+	emit_array(f, "Weft_Str", "str", get_count(E->strs));
+	emit_array(f, "Weft_Shuffle", "shuffle", get_count(E->shuffles));
+	emit_array(f, "Weft_List", "cell", get_count(E->cells));
+	emit_array(f, "Weft_Array", "array", get_count(E->arrays));
+	emit_array(f, "Weft_Vec", "vec", get_count(E->vecs));
+	emit_array(f, "Weft_PVec", "pvec", get_count(E->pvecs));
+	emit_array(f, "Weft_Dict", "dict", get_count(E->dicts));
+	fprintf(f, "\n");
+
+	if (get_count(E->builtins)) {
+		fprintf(f,
+		        "static Weft_Builtin *get_builtin(const char *name)\n"
+		        "{\n"
+		        "\tWeft_MapKey *key =\n"
+		        "\t\tmap_lookup_n(builtin_get_map(), name, strlen(name));\n"
+		        "\treturn map_key_get_data(key).ptr;\n"
+		        "}\n\n");
+	}
+}
+
+static void emit_cell(const Weft_EmitState *E, const Weft_List *list)
+{
+	fprintf(E->f, "\tcell[%zu] = new_list_node(", get_id(E, list));
+	emit_data(E, list->car);
+	fprintf(E->f, ", ");
+	emit_list_ref(E, list->cdr);
+	fprintf(E->f, ");\n");
+}
+
+static void emit_array_init(const Weft_EmitState *E, const Weft_Array *array)
+{
+	FILE *f = E->f;
+	size_t id = get_id(E, array);
+
+	fprintf(f,
+	        "\tarray[%zu] = new_array(%zu);\n",
+	        id,
+	        array_get_len(array));
+	for (size_t i = 0; i < array_get_len(array); i++) {
+		fprintf(f, "\tarray[%zu] = array_push(array[%zu], ", id, id);
+		emit_data(E, array_get(array, i));
+		fprintf(f, ");\n");
+	}
+}
+
+static void emit_pvec_init(const Weft_EmitState *E, const Weft_PVec *pvec)
+{
+	FILE *f = E->f;
+	size_t id = get_id(E, pvec);
+
+	fprintf(f, "\tpvec[%zu] = new_pvec();\n", id);
+	for (size_t i = 0; i < pvec_get_len(pvec); i++) {
+		fprintf(f, "\tpvec[%zu] = pvec_push(pvec[%zu], ", id, id);
+		emit_data(E, pvec_get(pvec, i));
+		fprintf(f, ");\n");
+	}
+}
+
+static void emit_dict_init(const Weft_EmitState *E, const Weft_Dict *dict)
+{
+	FILE *f = E->f;
+	size_t id = get_id(E, dict);
+
+	fprintf(f, "\tdict[%zu] = new_dict(%zu);\n", id, dict_get_len(dict));
+	for (size_t i = 0; i < dict_get_cap(dict); i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (!entry) {
+			continue;
+		}
+
+		fprintf(f, "\tdict[%zu] = dict_insert(dict[%zu], ", id, id);
+		emit_data(E, entry->key);
+		fprintf(f, ", ");
+		emit_data(E, entry->value);
+		fprintf(f, ");\n");
+	}
+}
+
+static void emit_init(const Weft_EmitState *E)
+{
+	FILE *f = E->f;
+
+	fprintf(f, "static void init(void)\n{\n");
+
+	for (size_t i = 0; i < get_count(E->builtins); i++) {
+		const Weft_Builtin *builtin = get_item(E->builtins, i);
+		fprintf(f, "\tbuiltin[%zu] = get_builtin(", i);
+		emit_bytes(f, builtin->name, strlen(builtin->name));
+		fprintf(f, ");\n");
+	}
+
+	for (size_t i = 0; i < get_count(E->fns); i++) {
+		const Weft_Fn *fn = get_item(E->fns, i);
+		fprintf(f, "\tfn[%zu] = new_fn_n(", i);
+		emit_bytes(f, fn->name, strlen(fn->name));
+		fprintf(f, ", %zu, NULL);\n", strlen(fn->name));
+	}
+
+	for (size_t i = 0; i < get_count(E->strs); i++) {
+		const Weft_Str *str = get_item(E->strs, i);
+		fprintf(f, "\tstr[%zu] = new_str_n(", i);
+		emit_bytes(f, str_get_ch(str), str->len);
+		fprintf(f, ", %zu);\n", str->len);
+	}
+
+	for (size_t i = 0; i < get_count(E->shuffles); i++) {
+		const Weft_Shuffle *shuffle = get_item(E->shuffles, i);
+		unsigned out_count = shuffle_get_out_count(shuffle);
+
+		fprintf(f,
+		        "\tshuffle[%zu] = new_shuffle(%u, %u);\n",
+		        i,
+		        shuffle_get_in_count(shuffle),
+		        out_count);
+		for (unsigned j = 0; j < out_count; j++) {
+			fprintf(f,
+			        "\tshuffle_set_out(shuffle[%zu], %u, %u);\n",
+			        i,
+			        j,
+			        shuffle_get_out(shuffle, j));
+		}
+	}
+
+	for (size_t i = 0; i < get_count(E->vecs); i++) {
+		static const char *const type[] = {
+			"WEFT_VEC_I64",
+			"WEFT_VEC_F64",
+			"WEFT_VEC_U32",
+		};
+		const Weft_Vec *vec = get_item(E->vecs, i);
+
+		fprintf(f,
+		        "\tvec[%zu] = new_vec(%s, %zu);\n",
+		        i,
+		        type[vec->type],
+		        vec->len);
+		for (size_t j = 0; j < vec->len; j++) {
+			fprintf(f, "\tvec_set(vec[%zu], %zu, ", i, j);
+			emit_data(E, vec_get(vec, j));
+			fprintf(f, ");\n");
+		}
+	}
+
+	const Weft_Data *order = buf_peek(E->order, buf_get_at(E->order));
+	for (size_t i = 0; i < buf_get_at(E->order) / sizeof(Weft_Data); i++) {
+		switch (order[i].type) {
+		case WEFT_DATA_LIST:
+			emit_cell(E, order[i].ptr);
+			break;
+		case WEFT_DATA_ARRAY:
+			emit_array_init(E, order[i].ptr);
+			break;
+		case WEFT_DATA_PVEC:
+			emit_pvec_init(E, order[i].ptr);
+			break;
+		case WEFT_DATA_DICT:
+			emit_dict_init(E, order[i].ptr);
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < get_count(E->fns); i++) {
+		fprintf(f, "\tfn[%zu]->list = ", i);
+		emit_list_ref(E, compile_fn(get_item(E->fns, i)));
+		fprintf(f, ";\n");
+		fprintf(f, "\tfn[%zu]->native = fn_%zu;\n", i, i);
+	}
+
+	fprintf(f, "}\n\n");
+}
+
+static void emit_code(const Weft_EmitState *E, const Weft_List *list)
+{
+	FILE *f = E->f;
+
+	for (; list; list = list->cdr) {
+		Weft_Data data = list->car;
+
+		switch (data.type) {
+		case WEFT_DATA_SHUFFLE:
+			fprintf(f,
+			        "\tif (!eval_shuffle(W, shuffle[%zu])) {\n",
+			        get_id(E, data.ptr));
+			break;
+		case WEFT_DATA_BUILTIN:
+			fprintf(f,
+			        effect_is_known(((const Weft_Builtin *)data.ptr)->effect)
+			            ? "\tif (!builtin[%zu]->fn(W)) {\n"
+			            : "\tif (!eval_apply(W, "
+			              "data_builtin(builtin[%zu]))) {\n",
+			        get_id(E, data.ptr));
+			break;
+		case WEFT_DATA_FN:
+			fprintf(f, "\tif (!fn_%zu(W)) {\n", get_id(E, data.ptr));
+			break;
+		default:
+			fprintf(f, "\teval_push(W, ");
+			emit_data(E, data);
+			fprintf(f, ");\n");
+			continue;
+		}
+		fprintf(f, "\t\treturn false;\n\t}\n");
+	}
+	fprintf(f, "\treturn true;\n}\n\n");
+}
+
+static void emit_protos(const Weft_EmitState *E)
+{
+	FILE *f = E->f;
+	size_t count = get_count(E->fns);
+
+	for (size_t i = 0; i < count; i++) {
+		fprintf(f, "static bool fn_%zu(Weft_EvalState *W);\n", i);
+	}
+	if (count) {
+		fprintf(f, "\n");
+	}
+}
+
+static void emit_fns(const Weft_EmitState *E, const Weft_List *ctrl)
+{
+	FILE *f = E->f;
+	size_t count = get_count(E->fns);
+
+	for (size_t i = 0; i < count; i++) {
+		Weft_Fn *fn = get_item(E->fns, i);
+		fprintf(f, "static bool fn_%zu(Weft_EvalState *W)\n{\n", i);
+		emit_code(E, compile_fn(fn));
+	}
+
+	fprintf(f, "static bool run(Weft_EvalState *W)\n{\n");
+	emit_code(E, ctrl);
+
+	fprintf(f,
+	        "int main(void)\n"
+	        "{\n"
+	        "\tinit();\n"
+	        "\n"
+	        "\tWeft_EvalState W;\n"
+	        "\teval_init(&W);\n"
+	        "\tbool ok = run(&W);\n"
+	        "\teval_exit(&W);\n"
+	        "\n"
+	        "\treturn ok ? 0 : 1;\n"
+	        "}\n");
+}
+
+bool emit_c(const char *path, Weft_List *ctrl)
+{
+	Weft_EmitState E = {
+		.ids = new_table(64),
+		.builtins = new_buf(16 * sizeof(void *)),
+		.fns = new_buf(16 * sizeof(void *)),
+		.strs = new_buf(16 * sizeof(void *)),
+		.shuffles = new_buf(16 * sizeof(void *)),
+		.cells = new_buf(64 * sizeof(void *)),
+		.arrays = new_buf(16 * sizeof(void *)),
+		.vecs = new_buf(16 * sizeof(void *)),
+		.pvecs = new_buf(16 * sizeof(void *)),
+		.dicts = new_buf(16 * sizeof(void *)),
+		.order = new_buf(64 * sizeof(Weft_Data)),
+		.pending = new_buf(16 * sizeof(void *)),
+	};
+	collect(&E, ctrl);
+
+	E.f = file_open(path, "w");
+	if (E.f) {
+		emit_prelude(&E);
+		emit_protos(&E);
+		emit_init(&E);
+		emit_fns(&E, ctrl);
+	}
+	bool ok = E.f && !ferror(E.f);
+
+	if (E.f && fclose(E.f)) {
+		ok = false;
+	}
+
+	table_free(E.ids);
+	buf_free(E.builtins);
+	buf_free(E.fns);
+	buf_free(E.strs);
+	buf_free(E.shuffles);
+	buf_free(E.cells);
+	buf_free(E.arrays);
+	buf_free(E.vecs);
+	buf_free(E.pvecs);
+	buf_free(E.dicts);
+	buf_free(E.order);
+	buf_free(E.pending);
+
+	return ok;
+}
@@ -0,0 +1,14 @@
+#ifndef WEFT_EMIT_H
+#define WEFT_EMIT_H
+
+#include <stdbool.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+
+// Functions
+
+bool emit_c(const char *path, Weft_List *ctrl);
+
+#endif
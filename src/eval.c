@@ -2,16 +2,40 @@
 #include "buf.h"
 #include "builtin.h"
 #include "data.h"
+#include "effect.h"
 #include "fn.h"
+#include "frame.h"
+#include "jit.h"
 #include "list.h"
+#include "lower.h"
+#include "shuffle.h"
 
+#include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Constants
+
+#define FMT_ERROR "\e[91m"
+#define FMT_RESET "\e[0m"
+
+static const unsigned FRAME_MAX = 16;
+static const size_t STACK_RESERVE = 1024;
+
+// Functions
 
 void eval_init(Weft_EvalState *W)
 {
 	W->ctrl = NULL;
-	W->stack = new_buf(sizeof(Weft_Data));
+	W->stack = new_buf(STACK_RESERVE * sizeof(Weft_Data));
 	W->nest = new_buf(sizeof(Weft_List *));
+	W->safe = 0;
+	W->silent = false;
+	W->shared = false;
 }
 
 void eval_exit(Weft_EvalState *W)
@@ -21,43 +45,343 @@ void eval_exit(Weft_EvalState *W)
 	W->nest = buf_free(W->nest);
 }
 
+void eval_reset(Weft_EvalState *W)
+{
+	W->ctrl = NULL;
+	W->stack = buf_clear(W->stack);
+	W->nest = buf_clear(W->nest);
+	W->safe = 0;
+}
+
+bool eval_error(Weft_EvalState *W, const char *fmt, ...)
+{
+	if (W->silent) {
+		return false;
+	}
+
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, FMT_ERROR "error: " FMT_RESET);
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+
+	return false;
+}
+
+size_t eval_get_depth(const Weft_EvalState *W)
+{
+	return buf_get_at(W->stack) / sizeof(Weft_Data);
+}
+
+bool eval_require(Weft_EvalState *W, size_t count, const char *name)
+{
+	if (W->safe) {
+		return true;
+	} else if (eval_get_depth(W) < count) {
+		return eval_error(W,
+		                  "%s: stack underflow (need %zu, have %zu)",
+		                  name,
+		                  count,
+		                  eval_get_depth(W));
+	}
+	return true;
+}
+
+static Weft_Data *get_top(const Weft_EvalState *W)
+{
+	return (Weft_Data *)(W->stack->raw + W->stack->at);
+}
+
+static Weft_Data *reserve(Weft_EvalState *W, size_t count)
+{
+	if (W->stack->at + count * sizeof(Weft_Data) > W->stack->cap) {
+		W->stack = buf_reserve(W->stack, count * sizeof(Weft_Data));
+	}
+	return get_top(W);
+}
+
+static void drop(Weft_EvalState *W, size_t count)
+{
+	W->stack->at -= count * sizeof(Weft_Data);
+}
+
+bool eval_reserve(Weft_EvalState *W, size_t need, size_t grow)
+{
+	if (!eval_require(W, need, "shuffle")) {
+		return false;
+	}
+	reserve(W, grow);
+	return true;
+}
+
+void eval_push(Weft_EvalState *W, Weft_Data data)
+{
+	W->stack = buf_push_data(W->stack, data);
+}
+
+Weft_Data eval_pop(Weft_EvalState *W)
+{
+	assert(eval_get_depth(W) > 0);
+
+	Weft_Data data = get_top(W)[-1];
+	drop(W, 1);
+
+	return data;
+}
+
+Weft_Data *eval_peek(const Weft_EvalState *W, size_t count)
+{
+	assert(eval_get_depth(W) >= count);
+
+	return get_top(W) - count;
+}
+
+bool eval_shuffle(Weft_EvalState *W, const Weft_Shuffle *shuffle)
+{
+	unsigned in_count = shuffle_get_in_count(shuffle);
+	unsigned out_count = shuffle_get_out_count(shuffle);
+
+	if (!eval_require(W, in_count, "shuffle")) {
+		return false;
+	}
+
+	Weft_Data local[FRAME_MAX];
+	Weft_Data *frame = local;
+	if (in_count > FRAME_MAX) {
+		frame = malloc(in_count * sizeof(Weft_Data));
+		if (!frame) {
+			fprintf(stderr,
+			        "Failed to allocate %zu bytes\n",
+			        in_count * sizeof(Weft_Data));
+			exit(1);
+		}
+	}
+
+	memcpy(frame, eval_peek(W, in_count), in_count * sizeof(Weft_Data));
+	drop(W, in_count);
+
+	Weft_Data *top = reserve(W, out_count);
+	for (unsigned i = 0; i < out_count; i++) {
+		top[i] = frame[shuffle_get_out(shuffle, i)];
+	}
+	W->stack->at += out_count * sizeof(Weft_Data);
+
+	if (frame != local) {
+		free(frame);
+	}
+	return true;
+}
+
+static bool eval_frame_src(Weft_EvalState *W, const Weft_Frame *frame)
+{
+	const Weft_List *src = frame->src;
+	for (unsigned i = 0; i < frame->len; i++, src = src->cdr) {
+		if (!eval_data(W, src->car)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool eval_frame(Weft_EvalState *W, Weft_Frame *frame)
+{
+	if (eval_get_depth(W) < frame->in_count) {
+		return eval_frame_src(W, frame);
+	}
+
+	Weft_Data local[FRAME_MAX];
+	Weft_Data *reg = local;
+
+	if (frame->size > FRAME_MAX) {
+		reg = malloc(frame->size * sizeof(Weft_Data));
+		if (!reg) {
+			fprintf(stderr,
+			        "Failed to allocate %zu bytes: %s\n",
+			        frame->size * sizeof(Weft_Data),
+			        strerror(errno));
+			exit(1);
+		}
+	}
+
+	unsigned in_count = frame->in_count;
+	memcpy(reg, eval_peek(W, in_count), in_count * sizeof(Weft_Data));
+	drop(W, in_count);
+
+	bool ok = true;
+	for (unsigned i = 0; ok && i < frame->op_count; i++) {
+		Weft_FrameOp *op = &frame->op[i];
+
+		if (op->data.type == WEFT_DATA_BUILTIN) {
+			Weft_Builtin *builtin = op->data.ptr;
+			Weft_Data arg[2] = {reg[op->arg[0]], reg[op->arg[1]]};
+			if (builtin->int_variant) {
+				builtin = builtin_specialize(builtin, arg);
+				if (!W->shared) {
+					op->data.ptr = builtin;
+				}
+			}
+			ok = builtin->binary(W, arg);
+			reg[op->dst] = arg[0];
+		} else {
+			reg[op->dst] = op->data;
+		}
+	}
+
+	if (ok) {
+		Weft_Data *top = reserve(W, frame->out_count);
+		for (unsigned i = 0; i < frame->out_count; i++) {
+			top[i] = reg[frame->out[i]];
+		}
+		W->stack->at += frame->out_count * sizeof(Weft_Data);
+	}
+
+	if (reg != local) {
+		free(reg);
+	}
+	return ok;
+}
+
+void eval_call(Weft_EvalState *W, Weft_List *list)
+{
+	W->nest = buf_push_ptr(W->nest, W->ctrl);
+	W->ctrl = list;
+}
+
 static bool eval_builtin(Weft_EvalState *W, Weft_Builtin *builtin)
 {
+	if (W->silent && !builtin->pure) {
+		return false;
+	}
 	return builtin->fn(W);
 }
 
-static void eval_fn(Weft_EvalState *W, Weft_Fn *fn)
+static bool eval_fn(Weft_EvalState *W, Weft_Fn *fn)
 {
-	W->nest = buf_push(W->nest, &W->ctrl, sizeof(Weft_List *));
-	W->ctrl = fn->list;
+	if (!W->silent && (W->shared ? fn->native != NULL : jit_prepare(fn))) {
+		if (!fn->native(W)) {
+			return false;
+		} else if (fn->rest) {
+			eval_call(W, fn->rest);
+		}
+		return true;
+	}
+
+	eval_call(W, lower_fn(fn));
+
+	if (!W->safe) {
+		Weft_Effect effect = effect_of_fn(fn);
+		if (effect_is_known(effect) && eval_get_depth(W) >= effect.in) {
+			W->safe = buf_get_at(W->nest);
+		}
+	}
+	return true;
 }
 
-bool eval(Weft_EvalState *W, Weft_List *ctrl)
+static void eval_return(Weft_EvalState *W)
 {
-	W->ctrl = ctrl;
+	W->nest = buf_pop_ptr(&W->ctrl, W->nest);
+	if (buf_get_at(W->nest) < W->safe) {
+		W->safe = 0;
+	}
+}
+
+bool eval_data(Weft_EvalState *W, Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_BUILTIN:
+		return eval_builtin(W, data.ptr);
+	case WEFT_DATA_FN:
+		return eval_fn(W, data.ptr);
+	case WEFT_DATA_SHUFFLE:
+		return eval_shuffle(W, data.ptr);
+	case WEFT_DATA_FRAME:
+		return eval_frame(W, data.ptr);
+	default:
+		eval_push(W, data);
+		return true;
+	}
+}
 
+static bool eval_site(Weft_EvalState *W)
+{
+	Weft_List *site = W->ctrl;
+	W->ctrl = site->cdr;
+
+	if (site->car.type != WEFT_DATA_BUILTIN) {
+		return eval_data(W, site->car);
+	}
+
+	Weft_Builtin *builtin = site->car.ptr;
+	if (builtin->int_variant && eval_get_depth(W) >= 2) {
+		builtin = builtin_specialize(builtin, eval_peek(W, 2));
+		if (!W->shared) {
+			site->car.ptr = builtin;
+		}
+	}
+	return eval_builtin(W, builtin);
+}
+
+bool eval_is_done(const Weft_EvalState *W)
+{
+	return !W->ctrl && !buf_get_at(W->nest);
+}
+
+bool eval_step(Weft_EvalState *W)
+{
+	if (W->ctrl) {
+		return eval_site(W);
+	} else if (buf_get_at(W->nest)) {
+		eval_return(W);
+	}
+	return true;
+}
+
+static bool eval_until(Weft_EvalState *W, size_t base)
+{
 	do {
 		while (W->ctrl) {
-			Weft_Data data = list_pop(&W->ctrl);
-			switch (data.type) {
-			case WEFT_DATA_BUILTIN:
-				if (!eval_builtin(W, data.ptr)) {
-					return false;
-				}
-				break;
-			case WEFT_DATA_FN:
-				eval_fn(W, data.ptr);
-				break;
-			default:
-				W->stack = buf_push(W->stack, &data, sizeof(Weft_Data));
-				break;
+			if (!eval_site(W)) {
+				return false;
 			}
 		}
 
-		while (buf_get_at(W->nest) && !W->ctrl) {
-			W->nest = buf_pop(&W->ctrl, W->nest, sizeof(Weft_List *));
+		while (buf_get_at(W->nest) > base && !W->ctrl) {
+			eval_return(W);
 		}
 	} while (W->ctrl);
 
 	return true;
 }
+
+bool eval(Weft_EvalState *W, Weft_List *ctrl)
+{
+	W->ctrl = ctrl;
+	return eval_until(W, 0);
+}
+
+bool eval_apply(Weft_EvalState *W, Weft_Data data)
+{
+	Weft_List *ctrl = W->ctrl;
+	size_t base = buf_get_at(W->nest);
+	size_t safe = W->safe;
+
+	W->ctrl = NULL;
+	W->safe = 0;
+
+	bool ok;
+	if (data.type == WEFT_DATA_LIST) {
+		W->ctrl = data.ptr;
+		ok = eval_until(W, base);
+	} else {
+		ok = eval_data(W, data) && eval_until(W, base);
+	}
+
+	if (!ok) {
+		W->nest = buf_drop(W->nest, buf_get_at(W->nest) - base);
+	}
+	W->ctrl = ctrl;
+	W->safe = safe;
+
+	return ok;
+}
@@ -2,25 +2,52 @@
 #define WEFT_EVAL_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // Forward Declarations
 
 typedef struct weft_buf Weft_Buf;
 typedef struct weft_list Weft_List;
+typedef struct weft_shuffle Weft_Shuffle;
+typedef struct weft_frame Weft_Frame;
 typedef struct weft_eval_state Weft_EvalState;
 
+// Local Includes
+
+#include "data.h"
+
 // Data Types
 
 struct weft_eval_state {
 	Weft_List *ctrl;
 	Weft_Buf *stack;
 	Weft_Buf *nest;
+	size_t safe;
+	bool silent;
+	bool shared;
 };
 
 // Functions
 
 void eval_init(Weft_EvalState *W);
 void eval_exit(Weft_EvalState *W);
+void eval_reset(Weft_EvalState *W);
+bool eval_error(Weft_EvalState *W, const char *fmt, ...);
+
+size_t eval_get_depth(const Weft_EvalState *W);
+bool eval_require(Weft_EvalState *W, size_t count, const char *name);
+bool eval_reserve(Weft_EvalState *W, size_t need, size_t grow);
+void eval_push(Weft_EvalState *W, Weft_Data data);
+Weft_Data eval_pop(Weft_EvalState *W);
+Weft_Data *eval_peek(const Weft_EvalState *W, size_t count);
+
+bool eval_shuffle(Weft_EvalState *W, const Weft_Shuffle *shuffle);
+bool eval_frame(Weft_EvalState *W, Weft_Frame *frame);
+void eval_call(Weft_EvalState *W, Weft_List *list);
+bool eval_data(Weft_EvalState *W, Weft_Data data);
+bool eval_is_done(const Weft_EvalState *W);
+bool eval_step(Weft_EvalState *W);
 bool eval(Weft_EvalState *W, Weft_List *ctrl);
+bool eval_apply(Weft_EvalState *W, Weft_Data data);
 
 #endif
@@ -2,7 +2,11 @@
 #include "gc.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 FILE *file_open(const char *path, const char *mode)
 {
@@ -48,3 +52,51 @@ size_t file_len(FILE *f)
 
 	return len;
 }
+
+const char *file_map(const char *path, size_t *len)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr,
+		        "Failed to open file '%s' for reading: %s\n",
+		        path,
+		        strerror(errno));
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		fprintf(stderr,
+		        "Failed to stat file '%s': %s\n",
+		        path,
+		        strerror(errno));
+		close(fd);
+		return NULL;
+	} else if (!st.st_size) {
+		close(fd);
+		*len = 0;
+		return "";
+	}
+
+	void *src = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (src == MAP_FAILED) {
+		fprintf(stderr,
+		        "Failed to map file '%s': %s\n",
+		        path,
+		        strerror(errno));
+		return NULL;
+	}
+
+	*len = st.st_size;
+	return src;
+}
+
+void file_unmap(const char *src, size_t len)
+{
+	if (!src || !len) {
+		return;
+	}
+	munmap((void *)src, len);
+}
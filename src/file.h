@@ -9,5 +9,7 @@ FILE *file_open(const char *path, const char *mode);
 FILE *file_open_n(const char *path, size_t path_len, const char *mode);
 void file_close(FILE *f);
 size_t file_len(FILE *f);
+const char *file_map(const char *path, size_t *len);
+void file_unmap(const char *src, size_t len);
 
 #endif
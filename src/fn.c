@@ -10,10 +10,40 @@ Weft_Fn *new_fn_n(const char *name, size_t name_len, Weft_List *list)
 	memcpy(fn->name, name, name_len);
 	fn->name[name_len] = 0;
 	fn->list = list;
+	fn->block = NULL;
+	fn->map = NULL;
+	fn->len = 0;
+	fn_clear_code(fn);
+	fn->effect.state = WEFT_EFFECT_PENDING;
 
 	return fn;
 }
 
+Weft_Fn *new_fn_stub_n(const char *name,
+                       size_t name_len,
+                       Weft_ParseBlock *block,
+                       Weft_Map *map)
+{
+	Weft_Fn *fn = new_fn_n(name, name_len, NULL);
+	fn->block = block;
+	fn->map = map;
+
+	return fn;
+}
+
+bool fn_is_stub(const Weft_Fn *fn)
+{
+	return fn->block;
+}
+
+void fn_clear_code(Weft_Fn *fn)
+{
+	fn->code = NULL;
+	fn->rest = NULL;
+	fn->native = NULL;
+	fn->calls = 0;
+}
+
 void fn_print(const Weft_Fn *fn)
 {
 	printf("%s", fn->name);
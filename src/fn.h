@@ -1,23 +1,45 @@
 #ifndef WEFT_FN_H
 #define WEFT_FN_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 // Forward Declarations
 
 typedef struct weft_list Weft_List;
+typedef struct weft_map Weft_Map;
+typedef struct weft_parse_block Weft_ParseBlock;
+typedef struct weft_eval_state Weft_EvalState;
 typedef struct weft_fn Weft_Fn;
 
+// Local Includes
+
+#include "effect.h"
+
 // Data Types
 
 struct weft_fn {
 	Weft_List *list;
+	Weft_ParseBlock *block;
+	Weft_Map *map;
+	Weft_List *code;
+	Weft_List *rest;
+	bool (*native)(Weft_EvalState *);
+	unsigned calls;
+	unsigned len;
+	Weft_Effect effect;
 	char name[];
 };
 
 // Functions
 
 Weft_Fn *new_fn_n(const char *name, size_t name_len, Weft_List *list);
+Weft_Fn *new_fn_stub_n(const char *name,
+                       size_t name_len,
+                       Weft_ParseBlock *block,
+                       Weft_Map *map);
+bool fn_is_stub(const Weft_Fn *fn);
+void fn_clear_code(Weft_Fn *fn);
 void fn_print(const Weft_Fn *fn);
 
 #endif
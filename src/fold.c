@@ -0,0 +1,206 @@
+#include "fold.h"
+#include "buf.h"
+#include "builtin.h"
+#include "compile.h"
+#include "data.h"
+#include "effect.h"
+#include "eval.h"
+#include "fn.h"
+#include "frame.h"
+#include "list.h"
+#include "table.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Globals
+
+static unsigned fold_limit = 1024;
+
+// Functions
+
+void fold_set_limit(unsigned limit)
+{
+	fold_limit = limit;
+}
+
+unsigned fold_get_limit(void)
+{
+	return fold_limit;
+}
+
+static bool is_literal(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_SHUFFLE:
+	case WEFT_DATA_BUILTIN:
+	case WEFT_DATA_FN:
+	case WEFT_DATA_FRAME:
+		return false;
+	default:
+		return true;
+	}
+}
+
+static bool is_foldable(Weft_Data data)
+{
+	return data.type != WEFT_DATA_BUILTIN
+	    || ((const Weft_Builtin *)data.ptr)->pure;
+}
+
+static bool is_pure_data(Weft_Table **seen_p, Weft_Data data);
+
+static bool is_pure_list(Weft_Table **seen_p, const Weft_List *list)
+{
+	for (; list; list = list->cdr) {
+		if (!is_pure_data(seen_p, list->car)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool is_pure_data(Weft_Table **seen_p, Weft_Data data)
+{
+	size_t value;
+
+	switch (data.type) {
+	case WEFT_DATA_BUILTIN:
+		return is_foldable(data)
+		    && effect_is_known(((const Weft_Builtin *)data.ptr)->effect);
+	case WEFT_DATA_LIST:
+		return is_pure_list(seen_p, data.ptr);
+	case WEFT_DATA_FRAME:
+		return is_pure_list(seen_p, ((const Weft_Frame *)data.ptr)->src);
+	case WEFT_DATA_FN:
+		if (table_lookup(&value, *seen_p, data.ptr)) {
+			return true;
+		}
+		*seen_p = table_insert(*seen_p, data.ptr, 1);
+		return is_pure_list(seen_p, compile_fn(data.ptr));
+	default:
+		return true;
+	}
+}
+
+bool fold_is_pure(Weft_Data data)
+{
+	Weft_Table *seen = new_table(64);
+	bool pure = is_pure_data(&seen, data);
+	table_free(seen);
+
+	return pure;
+}
+
+static bool is_stack_literal(const Weft_EvalState *W)
+{
+	size_t depth = eval_get_depth(W);
+	const Weft_Data *stack = eval_peek(W, depth);
+
+	for (size_t i = 0; i < depth; i++) {
+		if (!is_literal(stack[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static Weft_Data peek_next(const Weft_EvalState *W)
+{
+	if (W->ctrl) {
+		return W->ctrl->car;
+	}
+	return data_nil();
+}
+
+static Weft_Buf *save_stack(Weft_Buf *result, const Weft_EvalState *W)
+{
+	size_t depth = eval_get_depth(W);
+
+	result = buf_clear(result);
+	return buf_push(result, eval_peek(W, depth), depth * sizeof(Weft_Data));
+}
+
+static bool try_fold(Weft_Buf **result_p,
+                     Weft_List **end_p,
+                     Weft_EvalState *W,
+                     Weft_List *list)
+{
+	eval_reset(W);
+	W->ctrl = list;
+
+	bool found = false;
+	size_t consumed = 0;
+
+	for (unsigned steps = 0;; steps++) {
+		if (!buf_get_at(W->nest)) {
+			if (eval_get_depth(W) < consumed && is_stack_literal(W)) {
+				*result_p = save_stack(*result_p, W);
+				*end_p = W->ctrl;
+				found = true;
+			}
+
+			if (!W->ctrl) {
+				break;
+			}
+			consumed++;
+		}
+
+		if (steps >= fold_limit || !is_foldable(peek_next(W))
+		    || !eval_step(W)) {
+			break;
+		}
+	}
+	return found;
+}
+
+static Weft_List *append(Weft_List **list_p, Weft_List *node, Weft_Data data)
+{
+	Weft_List *next = new_list_node(data, NULL);
+	if (node) {
+		node->cdr = next;
+	} else {
+		*list_p = next;
+	}
+	return next;
+}
+
+Weft_List *fold_list(Weft_List *list)
+{
+	if (!fold_limit || !list) {
+		return list;
+	}
+
+	Weft_EvalState W;
+	eval_init(&W);
+	W.silent = true;
+
+	Weft_Buf *result = new_buf(sizeof(Weft_Data));
+	Weft_List *src = list;
+	Weft_List *dest = NULL;
+	Weft_List *node = NULL;
+	bool changed = false;
+
+	while (src) {
+		Weft_List *end;
+		if (!try_fold(&result, &end, &W, src)) {
+			node = append(&dest, node, src->car);
+			src = src->cdr;
+			continue;
+		}
+
+		const Weft_Data *data = buf_peek(result, buf_get_at(result));
+		size_t count = buf_get_at(result) / sizeof(Weft_Data);
+
+		for (size_t i = 0; i < count; i++) {
+			node = append(&dest, node, data[i]);
+		}
+		src = end;
+		changed = true;
+	}
+
+	buf_free(result);
+	eval_exit(&W);
+
+	return changed ? dest : list;
+}
@@ -0,0 +1,21 @@
+#ifndef WEFT_FOLD_H
+#define WEFT_FOLD_H
+
+#include <stdbool.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+
+// Local Includes
+
+#include "data.h"
+
+// Functions
+
+void fold_set_limit(unsigned limit);
+unsigned fold_get_limit(void);
+bool fold_is_pure(Weft_Data data);
+Weft_List *fold_list(Weft_List *list);
+
+#endif
@@ -0,0 +1,25 @@
+#include "frame.h"
+#include "gc.h"
+
+#include <stdio.h>
+
+Weft_Frame *new_frame(unsigned op_count, unsigned out_count)
+{
+	Weft_Frame *frame = gc_alloc(sizeof(Weft_Frame)
+	                             + op_count * sizeof(Weft_FrameOp)
+	                             + out_count * sizeof(unsigned));
+	frame->src = NULL;
+	frame->len = 0;
+	frame->in_count = 0;
+	frame->out_count = out_count;
+	frame->size = 0;
+	frame->op_count = op_count;
+	frame->out = (unsigned *)&frame->op[op_count];
+
+	return frame;
+}
+
+void frame_print(const Weft_Frame *frame)
+{
+	printf("<frame %u -- %u>", frame->in_count, frame->out_count);
+}
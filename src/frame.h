@@ -0,0 +1,38 @@
+#ifndef WEFT_FRAME_H
+#define WEFT_FRAME_H
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_frame_op Weft_FrameOp;
+typedef struct weft_frame Weft_Frame;
+
+// Local Includes
+
+#include "data.h"
+
+// Data Types
+
+struct weft_frame_op {
+	Weft_Data data;
+	unsigned dst;
+	unsigned arg[2];
+};
+
+struct weft_frame {
+	const Weft_List *src;
+	unsigned len;
+	unsigned in_count;
+	unsigned out_count;
+	unsigned size;
+	unsigned op_count;
+	unsigned *out;
+	Weft_FrameOp op[];
+};
+
+// Functions
+
+Weft_Frame *new_frame(unsigned op_count, unsigned out_count);
+void frame_print(const Weft_Frame *frame);
+
+#endif
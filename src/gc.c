@@ -7,7 +7,7 @@
 
 // Globals
 
-static Weft_GC *gc_head;
+static _Thread_local Weft_GC *gc_head;
 
 // Functions
 
@@ -36,6 +36,11 @@ static void mark_tag(Weft_GC *tag)
 	tag->prev |= 1;
 }
 
+static void unmark_tag(Weft_GC *tag)
+{
+	tag->prev &= ~(uintptr_t)1;
+}
+
 static Weft_GC *pop_tag(Weft_GC *tag)
 {
 	Weft_GC *prev = get_tag_prev(tag);
@@ -76,6 +81,33 @@ bool gc_mark(void *ptr)
 	return false;
 }
 
+bool gc_is_marked(void *ptr)
+{
+	return !ptr || is_tag_marked(get_tag(ptr));
+}
+
+Weft_GC *gc_detach(void)
+{
+	Weft_GC *heap = gc_head;
+	gc_head = NULL;
+
+	return heap;
+}
+
+void gc_attach(Weft_GC *heap)
+{
+	if (!heap) {
+		return;
+	}
+
+	Weft_GC *tail = heap;
+	while (get_tag_prev(tail)) {
+		tail = get_tag_prev(tail);
+	}
+	tail->prev = (uintptr_t)gc_head << 1 | (tail->prev & 1);
+	gc_head = heap;
+}
+
 void gc_collect(void)
 {
 	while (gc_head && !is_tag_marked(gc_head)) {
@@ -86,5 +118,6 @@ void gc_collect(void)
 		while (get_tag_prev(tag) && !is_tag_marked(get_tag_prev(tag))) {
 			set_tag_prev(tag, pop_tag(get_tag_prev(tag)));
 		}
+		unmark_tag(tag);
 	}
 }
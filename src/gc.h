@@ -20,6 +20,9 @@ struct weft_gc {
 
 void *gc_alloc(size_t size);
 bool gc_mark(void *ptr);
+bool gc_is_marked(void *ptr);
+Weft_GC *gc_detach(void);
+void gc_attach(Weft_GC *heap);
 void gc_collect(void);
 
 #endif
@@ -0,0 +1,616 @@
+#include "image.h"
+#include "array.h"
+#include "buf.h"
+#include "builtin.h"
+#include "compile.h"
+#include "data.h"
+#include "dict.h"
+#include "file.h"
+#include "fn.h"
+#include "gc.h"
+#include "list.h"
+#include "map.h"
+#include "pvec.h"
+#include "shuffle.h"
+#include "str.h"
+#include "table.h"
+#include "vec.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Forward Declarations
+
+typedef struct weft_image_header Weft_ImageHeader;
+typedef enum weft_image_kind Weft_ImageKind;
+typedef enum weft_image_reloc_type Weft_ImageRelocType;
+typedef struct weft_image_reloc Weft_ImageReloc;
+typedef struct weft_image_object Weft_ImageObject;
+typedef struct weft_image_writer Weft_ImageWriter;
+
+// Data Types
+
+struct weft_image_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t ptr_size;
+	uint32_t data_size;
+	uint64_t size;
+	uint64_t ctrl;
+	uint64_t map;
+	uint64_t reloc;
+	uint64_t reloc_count;
+};
+
+enum weft_image_kind {
+	WEFT_IMAGE_LIST,
+	WEFT_IMAGE_STR,
+	WEFT_IMAGE_SHUFFLE,
+	WEFT_IMAGE_FN,
+	WEFT_IMAGE_MAP,
+	WEFT_IMAGE_MAP_KEY,
+	WEFT_IMAGE_ARRAY,
+	WEFT_IMAGE_ARRAY_BUF,
+	WEFT_IMAGE_VEC,
+	WEFT_IMAGE_PVEC,
+	WEFT_IMAGE_PVEC_NODE,
+	WEFT_IMAGE_PVEC_LEAF,
+	WEFT_IMAGE_DICT,
+	WEFT_IMAGE_DICT_BUF,
+};
+
+enum weft_image_reloc_type {
+	WEFT_IMAGE_RELOC_PTR,
+	WEFT_IMAGE_RELOC_KEY,
+	WEFT_IMAGE_RELOC_BUILTIN,
+	WEFT_IMAGE_RELOC_BUILTIN_KEY,
+};
+
+struct weft_image_reloc {
+	uint64_t offset;
+	uint64_t type;
+	uint64_t name;
+};
+
+struct weft_image_object {
+	const void *ptr;
+	Weft_ImageKind kind;
+	uint64_t offset;
+};
+
+struct weft_image_writer {
+	Weft_Buf *image;
+	Weft_Buf *relocs;
+	Weft_Buf *pending;
+	Weft_Table *placed;
+};
+
+// Constants
+
+static const size_t IMAGE_ALIGN = 8;
+static const uintptr_t IMAGE_MARK = 1;
+
+// Functions
+
+static size_t align_size(size_t size)
+{
+	return (size + IMAGE_ALIGN - 1) & ~(IMAGE_ALIGN - 1);
+}
+
+static char *get_image_at(const Weft_ImageWriter *I, uint64_t offset)
+{
+	return (char *)buf_peek(I->image, buf_get_at(I->image)) + offset;
+}
+
+static uint64_t reserve(Weft_ImageWriter *I, size_t size)
+{
+	static const char zero[64];
+
+	uint64_t offset = buf_get_at(I->image);
+	size = align_size(size);
+
+	while (size) {
+		size_t chunk = (size < sizeof(zero)) ? size : sizeof(zero);
+		I->image = buf_push(I->image, zero, chunk);
+		size -= chunk;
+	}
+	return offset;
+}
+
+static size_t get_object_size(const void *ptr, Weft_ImageKind kind)
+{
+	switch (kind) {
+	case WEFT_IMAGE_LIST:
+		return sizeof(Weft_List);
+	case WEFT_IMAGE_STR:
+		return sizeof(Weft_Str) + ((const Weft_Str *)ptr)->len + 1;
+	case WEFT_IMAGE_SHUFFLE: {
+		const Weft_Shuffle *shuffle = ptr;
+		return sizeof(Weft_Shuffle)
+		     + shuffle_get_out_count(shuffle) * sizeof(unsigned);
+	}
+	case WEFT_IMAGE_FN:
+		return sizeof(Weft_Fn) + strlen(((const Weft_Fn *)ptr)->name) + 1;
+	case WEFT_IMAGE_MAP:
+		return sizeof(Weft_Map);
+	case WEFT_IMAGE_MAP_KEY:
+		return sizeof(Weft_MapKey);
+	case WEFT_IMAGE_ARRAY:
+		return sizeof(Weft_Array);
+	case WEFT_IMAGE_ARRAY_BUF:
+		return sizeof(Weft_ArrayBuf)
+		     + ((const Weft_ArrayBuf *)ptr)->len * sizeof(Weft_Data);
+	case WEFT_IMAGE_VEC: {
+		const Weft_Vec *vec = ptr;
+		return vec_get_size(vec->type, vec->len);
+	}
+	case WEFT_IMAGE_PVEC:
+		return sizeof(Weft_PVec);
+	case WEFT_IMAGE_PVEC_NODE:
+		return pvec_node_get_size(((const Weft_PVecNode *)ptr)->count);
+	case WEFT_IMAGE_PVEC_LEAF:
+		return pvec_leaf_get_size(((const Weft_PVecLeaf *)ptr)->count);
+	case WEFT_IMAGE_DICT:
+		return sizeof(Weft_Dict);
+	case WEFT_IMAGE_DICT_BUF:
+		return dict_buf_get_size(((const Weft_DictBuf *)ptr)->cap);
+	default:
+		return 0;
+	}
+}
+
+static uint64_t place(Weft_ImageWriter *I, const void *ptr, Weft_ImageKind kind)
+{
+	if (!ptr) {
+		return 0;
+	}
+
+	size_t offset;
+	if (table_lookup(&offset, I->placed, ptr)) {
+		return offset;
+	}
+
+	size_t size = get_object_size(ptr, kind);
+	uint64_t tag = reserve(I, sizeof(Weft_GC) + size);
+	*(uintptr_t *)get_image_at(I, tag) = IMAGE_MARK;
+
+	offset = tag + sizeof(Weft_GC);
+	memcpy(get_image_at(I, offset), ptr, size);
+	I->placed = table_insert(I->placed, ptr, offset);
+
+	Weft_ImageObject object = {
+		.ptr = ptr,
+		.kind = kind,
+		.offset = offset,
+	};
+	I->pending = buf_push(I->pending, &object, sizeof(Weft_ImageObject));
+
+	return offset;
+}
+
+static uint64_t place_name(Weft_ImageWriter *I, const Weft_Builtin *builtin)
+{
+	size_t offset;
+	if (table_lookup(&offset, I->placed, builtin)) {
+		return offset;
+	}
+
+	size_t len = strlen(builtin->name) + 1;
+	offset = reserve(I, len);
+	memcpy(get_image_at(I, offset), builtin->name, len);
+	I->placed = table_insert(I->placed, builtin, offset);
+
+	return offset;
+}
+
+static void add_reloc(Weft_ImageWriter *I,
+                      uint64_t offset,
+                      Weft_ImageRelocType type,
+                      uint64_t name)
+{
+	Weft_ImageReloc reloc = {
+		.offset = offset,
+		.type = type,
+		.name = name,
+	};
+	I->relocs = buf_push(I->relocs, &reloc, sizeof(Weft_ImageReloc));
+}
+
+static void set_ptr(Weft_ImageWriter *I, uint64_t field, uint64_t target)
+{
+	*(uintptr_t *)get_image_at(I, field) = target;
+	if (target) {
+		add_reloc(I, field, WEFT_IMAGE_RELOC_PTR, 0);
+	}
+}
+
+static void
+set_builtin(Weft_ImageWriter *I, uint64_t field, const Weft_Builtin *builtin)
+{
+	*(uintptr_t *)get_image_at(I, field) = 0;
+	add_reloc(I, field, WEFT_IMAGE_RELOC_BUILTIN, place_name(I, builtin));
+}
+
+static void write_data(Weft_ImageWriter *I, uint64_t field, Weft_Data data)
+{
+	uint64_t ptr_field = field + offsetof(Weft_Data, ptr);
+
+	switch (data.type) {
+	case WEFT_DATA_STR:
+		return set_ptr(
+			I, ptr_field, place(I, str_get_flat(data.ptr), WEFT_IMAGE_STR));
+	case WEFT_DATA_SHUFFLE:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_SHUFFLE));
+	case WEFT_DATA_LIST:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_LIST));
+	case WEFT_DATA_FN:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_FN));
+	case WEFT_DATA_ARRAY:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_ARRAY));
+	case WEFT_DATA_VEC:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_VEC));
+	case WEFT_DATA_PVEC:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_PVEC));
+	case WEFT_DATA_DICT:
+		return set_ptr(I, ptr_field, place(I, data.ptr, WEFT_IMAGE_DICT));
+	case WEFT_DATA_BUILTIN:
+		return set_builtin(I, ptr_field, data.ptr);
+	default:
+		break;
+	}
+}
+
+static void write_map_key(Weft_ImageWriter *I,
+                          uint64_t offset,
+                          const Weft_MapKey *key)
+{
+	set_ptr(I,
+	        offset + offsetof(Weft_MapKey, map),
+	        place(I, key->map, WEFT_IMAGE_MAP));
+
+	uint64_t field = offset + offsetof(Weft_MapKey, value);
+	Weft_Data data = map_key_get_data((Weft_MapKey *)key);
+
+	if (data.type == WEFT_DATA_BUILTIN) {
+		*(uintptr_t *)get_image_at(I, field) = 0;
+		add_reloc(
+			I, field, WEFT_IMAGE_RELOC_BUILTIN_KEY, place_name(I, data.ptr));
+	} else {
+		uint64_t target = place(I, data.ptr, WEFT_IMAGE_FN);
+		*(uintptr_t *)get_image_at(I, field) = target << 1;
+		add_reloc(I, field, WEFT_IMAGE_RELOC_KEY, 0);
+	}
+}
+
+static void write_object(Weft_ImageWriter *I, const Weft_ImageObject *object)
+{
+	uint64_t offset = object->offset;
+
+	switch (object->kind) {
+	case WEFT_IMAGE_LIST: {
+		const Weft_List *list = object->ptr;
+		write_data(I, offset + offsetof(Weft_List, car), list->car);
+		set_ptr(I,
+		        offset + offsetof(Weft_List, cdr),
+		        place(I, list->cdr, WEFT_IMAGE_LIST));
+		break;
+	}
+	case WEFT_IMAGE_STR:
+		set_ptr(I,
+		        offset + offsetof(Weft_Str, ch),
+		        offset + offsetof(Weft_Str, data));
+		break;
+	case WEFT_IMAGE_FN: {
+		Weft_Fn *fn = (Weft_Fn *)object->ptr;
+		set_ptr(I,
+		        offset + offsetof(Weft_Fn, list),
+		        place(I, compile_fn(fn), WEFT_IMAGE_LIST));
+		set_ptr(I, offset + offsetof(Weft_Fn, block), 0);
+		set_ptr(I, offset + offsetof(Weft_Fn, map), 0);
+		set_ptr(I, offset + offsetof(Weft_Fn, code), 0);
+		set_ptr(I, offset + offsetof(Weft_Fn, rest), 0);
+		set_ptr(I, offset + offsetof(Weft_Fn, native), 0);
+		*(unsigned *)get_image_at(I, offset + offsetof(Weft_Fn, calls)) = 0;
+		break;
+	}
+	case WEFT_IMAGE_MAP: {
+		const Weft_Map *map = object->ptr;
+		set_ptr(I,
+		        offset + offsetof(Weft_Map, key),
+		        place(I, map->key, WEFT_IMAGE_MAP_KEY));
+		set_ptr(I,
+		        offset + offsetof(Weft_Map, left),
+		        place(I, map->left, WEFT_IMAGE_MAP));
+		set_ptr(I,
+		        offset + offsetof(Weft_Map, right),
+		        place(I, map->right, WEFT_IMAGE_MAP));
+		break;
+	}
+	case WEFT_IMAGE_MAP_KEY:
+		write_map_key(I, offset, object->ptr);
+		break;
+	case WEFT_IMAGE_ARRAY: {
+		const Weft_Array *array = object->ptr;
+		set_ptr(I,
+		        offset + offsetof(Weft_Array, buf),
+		        place(I, array->buf, WEFT_IMAGE_ARRAY_BUF));
+		break;
+	}
+	case WEFT_IMAGE_ARRAY_BUF: {
+		const Weft_ArrayBuf *buf = object->ptr;
+		*(size_t *)get_image_at(I, offset + offsetof(Weft_ArrayBuf, cap)) =
+			buf->len;
+		for (size_t i = 0; i < buf->len; i++) {
+			write_data(I,
+			           offset + offsetof(Weft_ArrayBuf, data)
+			               + i * sizeof(Weft_Data),
+			           buf->data[i]);
+		}
+		break;
+	}
+	case WEFT_IMAGE_PVEC: {
+		const Weft_PVec *pvec = object->ptr;
+		set_ptr(I,
+		        offset + offsetof(Weft_PVec, root),
+		        place(I,
+		              pvec->root,
+		              pvec->shift ? WEFT_IMAGE_PVEC_NODE
+		                          : WEFT_IMAGE_PVEC_LEAF));
+		set_ptr(I,
+		        offset + offsetof(Weft_PVec, tail),
+		        place(I, pvec->tail, WEFT_IMAGE_PVEC_LEAF));
+		break;
+	}
+	case WEFT_IMAGE_PVEC_NODE: {
+		const Weft_PVecNode *node = object->ptr;
+		Weft_ImageKind kind = (node->shift > WEFT_PVEC_BITS)
+		                        ? WEFT_IMAGE_PVEC_NODE
+		                        : WEFT_IMAGE_PVEC_LEAF;
+		for (unsigned i = 0; i < node->count; i++) {
+			set_ptr(I,
+			        offset + offsetof(Weft_PVecNode, child)
+			            + i * sizeof(void *),
+			        place(I, node->child[i], kind));
+		}
+		break;
+	}
+	case WEFT_IMAGE_PVEC_LEAF: {
+		const Weft_PVecLeaf *leaf = object->ptr;
+		*(unsigned *)get_image_at(I, offset + offsetof(Weft_PVecLeaf, cap)) =
+			leaf->count;
+		for (unsigned i = 0; i < leaf->count; i++) {
+			write_data(I,
+			           offset + offsetof(Weft_PVecLeaf, data)
+			               + i * sizeof(Weft_Data),
+			           leaf->data[i]);
+		}
+		break;
+	}
+	case WEFT_IMAGE_DICT: {
+		const Weft_Dict *dict = object->ptr;
+		set_ptr(I,
+		        offset + offsetof(Weft_Dict, buf),
+		        place(I, dict->buf, WEFT_IMAGE_DICT_BUF));
+		break;
+	}
+	case WEFT_IMAGE_DICT_BUF: {
+		const Weft_DictBuf *buf = object->ptr;
+		*(size_t *)get_image_at(I, offset + offsetof(Weft_DictBuf, room)) =
+			buf->len;
+
+		uint64_t entries = offset + dict_buf_get_size(buf->cap)
+		                 - buf->cap * sizeof(Weft_DictEntry);
+		for (size_t i = 0; i < buf->cap; i++) {
+			const Weft_DictEntry *entry = dict_buf_get_entry(buf, i);
+			if (!entry) {
+				continue;
+			}
+
+			uint64_t field = entries + i * sizeof(Weft_DictEntry);
+			write_data(I, field + offsetof(Weft_DictEntry, key), entry->key);
+			write_data(
+				I, field + offsetof(Weft_DictEntry, value), entry->value);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void write_pending(Weft_ImageWriter *I)
+{
+	while (buf_get_at(I->pending)) {
+		Weft_ImageObject object;
+		I->pending =
+			buf_pop(&object, I->pending, sizeof(Weft_ImageObject));
+		write_object(I, &object);
+	}
+}
+
+static Weft_ImageHeader *get_header(const Weft_ImageWriter *I)
+{
+	return (Weft_ImageHeader *)get_image_at(I, 0);
+}
+
+bool image_save(const char *path, Weft_List *ctrl, Weft_Map *map)
+{
+	Weft_ImageWriter I = {
+		.image = new_buf(sizeof(Weft_ImageHeader)),
+		.relocs = new_buf(sizeof(Weft_ImageReloc)),
+		.pending = new_buf(sizeof(Weft_ImageObject)),
+		.placed = new_table(0),
+	};
+	reserve(&I, sizeof(Weft_ImageHeader));
+
+	uint64_t ctrl_offset = place(&I, ctrl, WEFT_IMAGE_LIST);
+	uint64_t map_offset = place(&I, map, WEFT_IMAGE_MAP);
+	write_pending(&I);
+
+	uint64_t reloc_offset = reserve(&I, buf_get_at(I.relocs));
+	memcpy(get_image_at(&I, reloc_offset),
+	       buf_peek(I.relocs, buf_get_at(I.relocs)),
+	       buf_get_at(I.relocs));
+
+	Weft_ImageHeader *header = get_header(&I);
+	memcpy(header->magic, WEFT_IMAGE_MAGIC, sizeof(WEFT_IMAGE_MAGIC));
+	header->version = WEFT_IMAGE_VERSION;
+	header->ptr_size = sizeof(void *);
+	header->data_size = sizeof(Weft_Data);
+	header->size = buf_get_at(I.image);
+	header->ctrl = ctrl_offset;
+	header->map = map_offset;
+	header->reloc = reloc_offset;
+	header->reloc_count = buf_get_at(I.relocs) / sizeof(Weft_ImageReloc);
+
+	bool ok = false;
+	FILE *f = file_open(path, "wb");
+	if (f) {
+		ok = fwrite(get_image_at(&I, 0), buf_get_at(I.image), 1, f);
+		file_close(f);
+
+		if (!ok) {
+			fprintf(stderr, "Failed to write image to '%s'\n", path);
+		}
+	}
+
+	buf_free(I.image);
+	buf_free(I.relocs);
+	buf_free(I.pending);
+	table_free(I.placed);
+
+	return ok;
+}
+
+static bool load_error(const char *path, const char *msg)
+{
+	fprintf(stderr, "Failed to load image '%s': %s\n", path, msg);
+	return false;
+}
+
+static bool check_header(const Weft_ImageHeader *header,
+                         size_t len,
+                         const char *path)
+{
+	if (len < sizeof(Weft_ImageHeader)
+	    || memcmp(header->magic, WEFT_IMAGE_MAGIC, sizeof(WEFT_IMAGE_MAGIC))) {
+		return load_error(path, "bad magic number");
+	} else if (header->version != WEFT_IMAGE_VERSION
+	           || header->ptr_size != sizeof(void *)
+	           || header->data_size != sizeof(Weft_Data)) {
+		return load_error(path, "incompatible image version");
+	} else if (header->size != len
+	           || header->reloc > len
+	           || header->reloc_count
+	                  > (len - header->reloc) / sizeof(Weft_ImageReloc)) {
+		return load_error(path, "truncated image");
+	}
+	return true;
+}
+
+static Weft_Builtin *
+lookup_builtin(Weft_Map *builtins, const char *base, uint64_t name)
+{
+	const char *src = base + name;
+	Weft_MapKey *key = map_lookup_n(builtins, src, strlen(src));
+	if (!key) {
+		return NULL;
+	}
+
+	Weft_Data data = map_key_get_data(key);
+	if (data.type != WEFT_DATA_BUILTIN) {
+		return NULL;
+	}
+	return data.ptr;
+}
+
+static bool apply_relocs(char *base, Weft_Map *builtins, const char *path)
+{
+	const Weft_ImageHeader *header = (const Weft_ImageHeader *)base;
+	const Weft_ImageReloc *reloc =
+		(const Weft_ImageReloc *)(base + header->reloc);
+
+	for (uint64_t i = 0; i < header->reloc_count; i++) {
+		if (reloc[i].offset + sizeof(uintptr_t) > header->reloc
+		    || reloc[i].name >= header->reloc) {
+			return load_error(path, "relocation out of range");
+		}
+
+		uintptr_t *field = (uintptr_t *)(base + reloc[i].offset);
+		Weft_Builtin *builtin;
+
+		switch (reloc[i].type) {
+		case WEFT_IMAGE_RELOC_PTR:
+			*field += (uintptr_t)base;
+			break;
+		case WEFT_IMAGE_RELOC_KEY:
+			*field += (uintptr_t)base << 1;
+			break;
+		case WEFT_IMAGE_RELOC_BUILTIN:
+		case WEFT_IMAGE_RELOC_BUILTIN_KEY:
+			builtin = lookup_builtin(builtins, base, reloc[i].name);
+			if (!builtin) {
+				fprintf(stderr,
+				        "Failed to load image '%s': builtin %s is undefined\n",
+				        path,
+				        base + reloc[i].name);
+				return false;
+			} else if (reloc[i].type == WEFT_IMAGE_RELOC_BUILTIN) {
+				*field = (uintptr_t)builtin;
+			} else {
+				*field = ((uintptr_t)builtin << 1) | 1;
+			}
+			break;
+		default:
+			return load_error(path, "invalid relocation");
+		}
+	}
+	return true;
+}
+
+bool image_load(Weft_List **ctrl_p,
+                Weft_Map **map_p,
+                Weft_Map *builtins,
+                const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr,
+		        "Failed to open file '%s' for reading: %s\n",
+		        path,
+		        strerror(errno));
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < sizeof(Weft_ImageHeader)) {
+		close(fd);
+		return load_error(path, "truncated image");
+	}
+
+	char *base = mmap(
+		NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (base == MAP_FAILED) {
+		return load_error(path, strerror(errno));
+	}
+
+	const Weft_ImageHeader *header = (const Weft_ImageHeader *)base;
+	if (!check_header(header, st.st_size, path)
+	    || !apply_relocs(base, builtins, path)) {
+		munmap(base, st.st_size);
+		return false;
+	}
+
+	*ctrl_p = header->ctrl ? (Weft_List *)(base + header->ctrl) : NULL;
+	*map_p = header->map ? (Weft_Map *)(base + header->map) : NULL;
+
+	return true;
+}
@@ -0,0 +1,25 @@
+#ifndef WEFT_IMAGE_H
+#define WEFT_IMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_map Weft_Map;
+
+// Constants
+
+static const char WEFT_IMAGE_MAGIC[4] = {'W', 'F', 'T', 'I'};
+static const uint32_t WEFT_IMAGE_VERSION = 12;
+
+// Functions
+
+bool image_save(const char *path, Weft_List *ctrl, Weft_Map *map);
+bool image_load(Weft_List **ctrl_p,
+                Weft_Map **map_p,
+                Weft_Map *builtins,
+                const char *path);
+
+#endif
@@ -0,0 +1,103 @@
+#include "inline.h"
+#include "compile.h"
+#include "data.h"
+#include "fn.h"
+#include "list.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Globals
+
+static unsigned inline_limit = 4;
+
+// Functions
+
+void inline_set_limit(unsigned limit)
+{
+	inline_limit = limit;
+}
+
+unsigned inline_get_limit(void)
+{
+	return inline_limit;
+}
+
+static bool is_small(const Weft_List *body)
+{
+	for (unsigned len = 0; body; len++) {
+		if (len >= inline_limit) {
+			return false;
+		}
+		body = body->cdr;
+	}
+	return true;
+}
+
+static bool is_inlinable(Weft_Data data)
+{
+	if (data.type != WEFT_DATA_FN) {
+		return false;
+	}
+
+	Weft_Fn *fn = data.ptr;
+	return fn->len <= inline_limit && is_small(compile_fn(fn));
+}
+
+static bool has_inlinable(const Weft_List *list)
+{
+	for (; list; list = list->cdr) {
+		if (is_inlinable(list->car)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static Weft_List *append(Weft_List **list_p, Weft_List *node, Weft_Data data)
+{
+	Weft_List *next = new_list_node(data, NULL);
+	if (node) {
+		node->cdr = next;
+	} else {
+		*list_p = next;
+	}
+	return next;
+}
+
+static void link_tail(Weft_List **list_p, Weft_List *node, Weft_List *tail)
+{
+	if (node) {
+		node->cdr = tail;
+	} else {
+		*list_p = tail;
+	}
+}
+
+Weft_List *inline_list(Weft_List *list)
+{
+	if (!inline_limit || !has_inlinable(list)) {
+		return list;
+	}
+
+	Weft_List *dest = NULL;
+	Weft_List *node = NULL;
+
+	for (; list; list = list->cdr) {
+		if (!is_inlinable(list->car)) {
+			node = append(&dest, node, list->car);
+			continue;
+		}
+
+		Weft_List *body = compile_fn(list->car.ptr);
+		if (!list->cdr) {
+			link_tail(&dest, node, body);
+			return dest;
+		}
+
+		for (; body; body = body->cdr) {
+			node = append(&dest, node, body->car);
+		}
+	}
+	return dest;
+}
@@ -0,0 +1,14 @@
+#ifndef WEFT_INLINE_H
+#define WEFT_INLINE_H
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+
+// Functions
+
+void inline_set_limit(unsigned limit);
+unsigned inline_get_limit(void);
+Weft_List *inline_list(Weft_List *list);
+
+#endif
@@ -0,0 +1,203 @@
+#include "intern.h"
+#include "buf.h"
+#include "data.h"
+#include "gc.h"
+#include "list.h"
+#include "table.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool intern_enabled = false;
+static Weft_Intern *intern = NULL;
+static Weft_Table *hashes = NULL;
+static size_t shared_count = 0;
+
+void intern_set_enabled(bool enabled)
+{
+	intern_enabled = enabled;
+}
+
+bool intern_is_enabled(void)
+{
+	return intern_enabled;
+}
+
+static Weft_Intern *new_intern(size_t cap)
+{
+	Weft_Intern *table =
+		calloc(1, sizeof(Weft_Intern) + cap * sizeof(Weft_InternEntry));
+	if (!table) {
+		fprintf(stderr,
+		        "Failed to allocate %zu bytes: %s\n",
+		        sizeof(Weft_Intern) + cap * sizeof(Weft_InternEntry),
+		        strerror(errno));
+		exit(1);
+	}
+
+	table->cap = cap;
+	table->count = 0;
+
+	return table;
+}
+
+static uint64_t get_hash(const Weft_List *list)
+{
+	size_t hash = 0;
+	if (list) {
+		table_lookup(&hash, hashes, list);
+	}
+	return hash;
+}
+
+static uint64_t hash_node(Weft_Data car, const Weft_List *cdr)
+{
+	uint64_t hash = car.type == WEFT_DATA_LIST
+	              ? data_hash_combine(WEFT_DATA_LIST, get_hash(car.ptr))
+	              : data_hash(car);
+
+	return data_hash_combine(hash, get_hash(cdr));
+}
+
+static bool is_same(Weft_Data left, Weft_Data right)
+{
+	if (left.type != right.type) {
+		return false;
+	}
+
+	switch (left.type) {
+	case WEFT_DATA_FLOAT:
+		return !memcmp(&left.fnum, &right.fnum, sizeof(left.fnum));
+	case WEFT_DATA_LIST:
+		return left.ptr == right.ptr;
+	default:
+		return data_equal(left, right);
+	}
+}
+
+static Weft_InternEntry *find_entry(Weft_Intern *table,
+                                    Weft_Data car,
+                                    const Weft_List *cdr,
+                                    uint64_t hash)
+{
+	size_t mask = table->cap - 1;
+	size_t index = hash & mask;
+
+	for (;; index = (index + 1) & mask) {
+		Weft_InternEntry *entry = &table->entry[index];
+		if (!entry->node
+		    || (entry->hash == hash && entry->node->cdr == cdr
+		        && is_same(entry->node->car, car))) {
+			return entry;
+		}
+	}
+}
+
+static void move_entry(Weft_Intern *dest, Weft_InternEntry entry)
+{
+	Weft_List *node = entry.node;
+	*find_entry(dest, node->car, node->cdr, entry.hash) = entry;
+	dest->count++;
+}
+
+static void insert_entry(Weft_List *node, uint64_t hash)
+{
+	if (4 * (intern->count + 1) > 3 * intern->cap) {
+		Weft_Intern *grown = new_intern(2 * intern->cap);
+		for (size_t i = 0; i < intern->cap; i++) {
+			if (intern->entry[i].node) {
+				move_entry(grown, intern->entry[i]);
+			}
+		}
+		free(intern);
+		intern = grown;
+	}
+
+	Weft_InternEntry *entry = find_entry(intern, node->car, node->cdr, hash);
+	entry->hash = hash;
+	entry->node = node;
+	intern->count++;
+
+	hashes = table_insert(hashes, node, hash);
+}
+
+static Weft_List *intern_node(Weft_List *node, Weft_Data car, Weft_List *cdr)
+{
+	uint64_t hash = hash_node(car, cdr);
+	Weft_InternEntry *entry = find_entry(intern, car, cdr, hash);
+
+	if (entry->node) {
+		shared_count++;
+		return entry->node;
+	} else if (node->cdr != cdr || !is_same(node->car, car)) {
+		node = new_list_node(car, cdr);
+	}
+
+	insert_entry(node, hash);
+	return node;
+}
+
+static bool is_interned(const Weft_List *list)
+{
+	size_t hash;
+	return !list || table_lookup(&hash, hashes, list);
+}
+
+Weft_List *intern_list(Weft_List *list)
+{
+	if (!intern_enabled) {
+		return list;
+	} else if (!intern) {
+		intern = new_intern(64);
+		hashes = new_table(64);
+	}
+
+	Weft_Buf *stack = new_buf(sizeof(Weft_List *));
+	for (; !is_interned(list); list = list->cdr) {
+		stack = buf_push_ptr(stack, list);
+	}
+
+	while (buf_get_at(stack)) {
+		Weft_List *node;
+		stack = buf_pop_ptr(&node, stack);
+
+		Weft_Data car = node->car;
+		if (car.type == WEFT_DATA_LIST) {
+			car = data_list(intern_list(car.ptr));
+		}
+		list = intern_node(node, car, list);
+	}
+	buf_free(stack);
+
+	return list;
+}
+
+size_t intern_get_shared_count(void)
+{
+	return shared_count;
+}
+
+void intern_sweep(void)
+{
+	if (!intern) {
+		return;
+	}
+
+	Weft_Intern *swept = new_intern(intern->cap);
+	Weft_Table *swept_hashes = new_table(table_get_count(hashes));
+
+	for (size_t i = 0; i < intern->cap; i++) {
+		Weft_InternEntry entry = intern->entry[i];
+		if (entry.node && gc_is_marked(entry.node)) {
+			move_entry(swept, entry);
+			swept_hashes = table_insert(swept_hashes, entry.node, entry.hash);
+		}
+	}
+
+	free(intern);
+	intern = swept;
+	table_free(hashes);
+	hashes = swept_hashes;
+}
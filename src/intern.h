@@ -0,0 +1,35 @@
+#ifndef WEFT_INTERN_H
+#define WEFT_INTERN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_intern_entry Weft_InternEntry;
+typedef struct weft_intern Weft_Intern;
+
+// Data Types
+
+struct weft_intern_entry {
+	uint64_t hash;
+	Weft_List *node;
+};
+
+struct weft_intern {
+	size_t cap;
+	size_t count;
+	Weft_InternEntry entry[];
+};
+
+// Functions
+
+void intern_set_enabled(bool enabled);
+bool intern_is_enabled(void);
+Weft_List *intern_list(Weft_List *list);
+size_t intern_get_shared_count(void);
+void intern_sweep(void);
+
+#endif
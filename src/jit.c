@@ -0,0 +1,415 @@
+#include "jit.h"
+#include "buf.h"
+#include "builtin.h"
+#include "data.h"
+#include "effect.h"
+#include "eval.h"
+#include "fn.h"
+#include "list.h"
+#include "lower.h"
+#include "shuffle.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define WEFT_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+// Constants
+
+#define JIT_CHUNK_SIZE 65536
+
+// Globals
+
+static unsigned jit_threshold = 16;
+
+#ifdef WEFT_JIT_X86_64
+static unsigned char *jit_chunk;
+static size_t jit_chunk_at;
+static size_t jit_chunk_cap;
+#endif
+
+// Functions
+
+void jit_set_threshold(unsigned threshold)
+{
+	jit_threshold = threshold;
+}
+
+#ifdef WEFT_JIT_X86_64
+
+static bool is_native(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_FN:
+		return false;
+	case WEFT_DATA_BUILTIN:
+		return effect_is_known(((const Weft_Builtin *)data.ptr)->effect);
+	default:
+		return true;
+	}
+}
+
+static Weft_Buf *emit(Weft_Buf *code, const void *bytes, size_t size)
+{
+	return buf_push(code, bytes, size);
+}
+
+static Weft_Buf *emit_imm64(Weft_Buf *code, unsigned char reg, uint64_t imm)
+{
+	unsigned char op[2] = {0x48, 0xb8 + reg};
+	code = emit(code, op, sizeof(op));
+	return emit(code, &imm, sizeof(imm));
+}
+
+static Weft_Buf *emit_call(Weft_Buf *code, const void *target)
+{
+	static const unsigned char mov_rdi_rbx[] = {0x48, 0x89, 0xdf};
+	static const unsigned char call_rax[] = {0xff, 0xd0};
+
+	code = emit(code, mov_rdi_rbx, sizeof(mov_rdi_rbx));
+	code = emit_imm64(code, 0, (uintptr_t)target);
+	return emit(code, call_rax, sizeof(call_rax));
+}
+
+static Weft_Buf *emit_check(Weft_Buf *code, Weft_Buf **fixup_p)
+{
+	static const unsigned char test_jz[] = {0x84, 0xc0, 0x0f, 0x84};
+	static const int32_t rel = 0;
+
+	code = emit(code, test_jz, sizeof(test_jz));
+
+	size_t at = buf_get_at(code);
+	*fixup_p = buf_push(*fixup_p, &at, sizeof(at));
+
+	return emit(code, &rel, sizeof(rel));
+}
+
+static Weft_Buf *emit_data(Weft_Buf *code, Weft_Buf **fixup_p, Weft_Data data)
+{
+	if (data.type == WEFT_DATA_BUILTIN) {
+		code = emit_call(code, ((const Weft_Builtin *)data.ptr)->fn);
+	} else {
+		code = emit_imm64(code, 6, (uintptr_t)data.ptr);
+		code = emit_call(code, eval_frame);
+	}
+	return emit_check(code, fixup_p);
+}
+
+static bool is_inline(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_FN:
+	case WEFT_DATA_BUILTIN:
+	case WEFT_DATA_FRAME:
+		return false;
+	default:
+		return true;
+	}
+}
+
+static long max_slot(long x, long y)
+{
+	return (x > y) ? x : y;
+}
+
+static Weft_List *measure(Weft_List *list, long *need_p, long *grow_p)
+{
+	long top = 0;
+	long need = 0;
+	long grow = 0;
+
+	for (; list && is_inline(list->car); list = list->cdr) {
+		if (list->car.type != WEFT_DATA_SHUFFLE) {
+			grow = max_slot(grow, ++top);
+			continue;
+		}
+
+		const Weft_Shuffle *shuffle = list->car.ptr;
+		long in = shuffle_get_in_count(shuffle);
+		long out = shuffle_get_out_count(shuffle);
+		long base = top - in;
+
+		need = max_slot(need, -base);
+		grow = max_slot(grow, base + max_slot(in, out) + in);
+		top = base + out;
+	}
+
+	*need_p = need;
+	*grow_p = grow;
+	return list;
+}
+
+static Weft_Buf *
+emit_op32(Weft_Buf *code, const unsigned char *op, size_t size, long imm)
+{
+	int32_t imm32 = (int32_t)imm;
+
+	code = emit(code, op, size);
+	return emit(code, &imm32, sizeof(imm32));
+}
+
+static int32_t get_disp(long slot)
+{
+	return (int32_t)(slot * (long)sizeof(Weft_Data));
+}
+
+static Weft_Buf *emit_store(Weft_Buf *code, long slot, Weft_Data data)
+{
+	static const unsigned char mov_r8_imm[] = {0x49, 0xb8};
+	static const unsigned char mov_rdx_r8[] = {0x4c, 0x89, 0x82};
+
+	uint64_t word[2];
+	memcpy(word, &data, sizeof(word));
+
+	for (unsigned i = 0; i < 2; i++) {
+		code = emit(code, mov_r8_imm, sizeof(mov_r8_imm));
+		code = emit(code, &word[i], sizeof(word[i]));
+		code = emit_op32(code,
+		                 mov_rdx_r8,
+		                 sizeof(mov_rdx_r8),
+		                 get_disp(slot) + i * sizeof(uint64_t));
+	}
+	return code;
+}
+
+static Weft_Buf *emit_copy(Weft_Buf *code, long from, long to)
+{
+	static const unsigned char load_xmm0[] = {0xf3, 0x0f, 0x6f, 0x82};
+	static const unsigned char store_xmm0[] = {0xf3, 0x0f, 0x7f, 0x82};
+
+	code = emit_op32(code, load_xmm0, sizeof(load_xmm0), get_disp(from));
+	return emit_op32(code, store_xmm0, sizeof(store_xmm0), get_disp(to));
+}
+
+static Weft_Buf *
+emit_shuffle(Weft_Buf *code, long *top_p, const Weft_Shuffle *shuffle)
+{
+	long in = shuffle_get_in_count(shuffle);
+	long out = shuffle_get_out_count(shuffle);
+	long base = *top_p - in;
+	long frame = base + max_slot(in, out);
+
+	for (long i = 0; i < in; i++) {
+		code = emit_copy(code, base + i, frame + i);
+	}
+	for (long i = 0; i < out; i++) {
+		long from = shuffle_get_out(shuffle, i);
+		if (from != i) {
+			code = emit_copy(code, frame + from, base + i);
+		}
+	}
+
+	*top_p = base + out;
+	return code;
+}
+
+static Weft_Buf *
+emit_jump(Weft_Buf *code, const unsigned char *op, size_t *at_p)
+{
+	static const int32_t rel = 0;
+
+	code = emit(code, op, 2);
+	*at_p = buf_get_at(code);
+
+	return emit(code, &rel, sizeof(rel));
+}
+
+static void patch_jump(Weft_Buf *code, size_t at)
+{
+	size_t size = buf_get_at(code);
+	unsigned char *bytes = (unsigned char *)buf_peek(code, size);
+	int32_t rel = (int32_t)(size - (at + sizeof(rel)));
+
+	memcpy(bytes + at, &rel, sizeof(rel));
+}
+
+static Weft_Buf *emit_top(Weft_Buf *code)
+{
+	static const unsigned char mov_rax_stack[] = {0x48, 0x8b, 0x83};
+	static const unsigned char mov_rcx_at[] = {0x48, 0x8b, 0x88};
+
+	code = emit_op32(code,
+	                 mov_rax_stack,
+	                 sizeof(mov_rax_stack),
+	                 offsetof(Weft_EvalState, stack));
+	return emit_op32(code,
+	                 mov_rcx_at,
+	                 sizeof(mov_rcx_at),
+	                 offsetof(Weft_Buf, at));
+}
+
+static Weft_List *
+emit_segment(Weft_Buf **code_p, Weft_Buf **fixup_p, Weft_List *list)
+{
+	static const unsigned char cmp_rcx[] = {0x48, 0x81, 0xf9};
+	static const unsigned char jb[] = {0x0f, 0x82};
+	static const unsigned char lea_rdx_rcx[] = {0x48, 0x8d, 0x91};
+	static const unsigned char cmp_rdx_cap[] = {0x48, 0x3b, 0x90};
+	static const unsigned char jbe[] = {0x0f, 0x86};
+	static const unsigned char mov_esi[] = {0xbe};
+	static const unsigned char mov_edx[] = {0xba};
+	static const unsigned char lea_rdx_top[] = {0x48, 0x8d, 0x94, 0x08};
+	static const unsigned char add_at[] = {0x48, 0x81, 0x80};
+
+	long need;
+	long grow;
+	Weft_List *end = measure(list, &need, &grow);
+
+	Weft_Buf *code = emit_top(*code_p);
+	size_t slow = 0;
+	size_t fast;
+
+	if (need) {
+		code = emit_op32(code, cmp_rcx, sizeof(cmp_rcx), get_disp(need));
+		code = emit_jump(code, jb, &slow);
+	}
+	code = emit_op32(code, lea_rdx_rcx, sizeof(lea_rdx_rcx), get_disp(grow));
+	code = emit_op32(code,
+	                 cmp_rdx_cap,
+	                 sizeof(cmp_rdx_cap),
+	                 offsetof(Weft_Buf, cap));
+	code = emit_jump(code, jbe, &fast);
+
+	if (slow) {
+		patch_jump(code, slow);
+	}
+	code = emit_op32(code, mov_esi, sizeof(mov_esi), need);
+	code = emit_op32(code, mov_edx, sizeof(mov_edx), grow);
+	code = emit_call(code, eval_reserve);
+	code = emit_check(code, fixup_p);
+	code = emit_top(code);
+
+	patch_jump(code, fast);
+	code = emit_op32(code,
+	                 lea_rdx_top,
+	                 sizeof(lea_rdx_top),
+	                 offsetof(Weft_Buf, raw));
+
+	long top = 0;
+	for (; list != end; list = list->cdr) {
+		if (list->car.type == WEFT_DATA_SHUFFLE) {
+			code = emit_shuffle(code, &top, list->car.ptr);
+		} else {
+			code = emit_store(code, top++, list->car);
+		}
+	}
+
+	if (top) {
+		int32_t size = get_disp(top);
+		code = emit_op32(code, add_at, sizeof(add_at), offsetof(Weft_Buf, at));
+		code = emit(code, &size, sizeof(size));
+	}
+
+	*code_p = code;
+	return end;
+}
+
+static void *install(const void *src, size_t size)
+{
+	size_t aligned = (size + 15) & ~(size_t)15;
+
+	if (!jit_chunk || jit_chunk_at + aligned > jit_chunk_cap) {
+		size_t cap = aligned > JIT_CHUNK_SIZE ? aligned : JIT_CHUNK_SIZE;
+		void *chunk = mmap(NULL,
+		                   cap,
+		                   PROT_READ | PROT_WRITE,
+		                   MAP_PRIVATE | MAP_ANONYMOUS,
+		                   -1,
+		                   0);
+		if (chunk == MAP_FAILED) {
+			return NULL;
+		}
+
+		jit_chunk = chunk;
+		jit_chunk_at = 0;
+		jit_chunk_cap = cap;
+	} else if (mprotect(jit_chunk, jit_chunk_cap, PROT_READ | PROT_WRITE)) {
+		return NULL;
+	}
+
+	unsigned char *dest = jit_chunk + jit_chunk_at;
+	memcpy(dest, src, size);
+	jit_chunk_at += aligned;
+
+	if (mprotect(jit_chunk, jit_chunk_cap, PROT_READ | PROT_EXEC)) {
+		return NULL;
+	}
+	return dest;
+}
+
+static void jit_compile(Weft_Fn *fn)
+{
+	static const unsigned char prologue[] = {0x53, 0x48, 0x89, 0xfb};
+	static const unsigned char epilogue[] = {
+		0xb8, 0x01, 0x00, 0x00, 0x00, 0x5b, 0xc3, 0x31, 0xc0, 0x5b, 0xc3,
+	};
+
+	_Static_assert(sizeof(Weft_Data) == 16, "Weft_Data must fit two registers");
+
+	Weft_List *list = lower_fn(fn);
+	if (!list || !is_native(list->car)) {
+		return;
+	}
+
+	Weft_Buf *code = new_buf(256);
+	Weft_Buf *fixup = new_buf(16 * sizeof(size_t));
+
+	code = emit(code, prologue, sizeof(prologue));
+	while (list && is_native(list->car)) {
+		if (is_inline(list->car)) {
+			list = emit_segment(&code, &fixup, list);
+		} else {
+			code = emit_data(code, &fixup, list->car);
+			list = list->cdr;
+		}
+	}
+	code = emit(code, epilogue, sizeof(epilogue));
+
+	size_t size = buf_get_at(code);
+	unsigned char *bytes = (unsigned char *)buf_peek(code, size);
+	size_t fail = size - 4;
+
+	while (buf_get_at(fixup)) {
+		size_t at;
+		fixup = buf_pop(&at, fixup, sizeof(at));
+
+		int32_t rel = (int32_t)(fail - (at + sizeof(rel)));
+		memcpy(bytes + at, &rel, sizeof(rel));
+	}
+
+	void *native = install(bytes, size);
+	if (native) {
+		fn->native = (bool (*)(Weft_EvalState *))native;
+		fn->rest = list;
+	}
+
+	buf_free(code);
+	buf_free(fixup);
+}
+
+#else
+
+static void jit_compile(Weft_Fn *fn)
+{
+	(void)fn;
+}
+
+#endif
+
+bool jit_prepare(Weft_Fn *fn)
+{
+	if (fn->native) {
+		return true;
+	} else if (!jit_threshold) {
+		return false;
+	} else if (fn->calls > jit_threshold) {
+		return false;
+	} else if (++fn->calls > jit_threshold) {
+		jit_compile(fn);
+	}
+	return fn->native;
+}
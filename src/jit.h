@@ -0,0 +1,15 @@
+#ifndef WEFT_JIT_H
+#define WEFT_JIT_H
+
+#include <stdbool.h>
+
+// Forward Declarations
+
+typedef struct weft_fn Weft_Fn;
+
+// Functions
+
+void jit_set_threshold(unsigned threshold);
+bool jit_prepare(Weft_Fn *fn);
+
+#endif
@@ -0,0 +1,329 @@
+#include "lower.h"
+#include "builtin.h"
+#include "compile.h"
+#include "data.h"
+#include "effect.h"
+#include "fn.h"
+#include "frame.h"
+#include "list.h"
+#include "shuffle.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forward Declarations
+
+typedef struct weft_lower_state Weft_LowerState;
+
+// Data Types
+
+struct weft_lower_state {
+	unsigned in_count;
+	unsigned op_count;
+	unsigned height;
+	unsigned *stack;
+	Weft_Data *data;
+	unsigned (*arg)[2];
+	unsigned *last;
+	unsigned *reg;
+	bool *busy;
+};
+
+// Globals
+
+static unsigned lower_limit = 64;
+
+// Functions
+
+void lower_set_limit(unsigned limit)
+{
+	lower_limit = limit;
+}
+
+unsigned lower_get_limit(void)
+{
+	return lower_limit;
+}
+
+static bool is_op(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_SHUFFLE:
+	case WEFT_DATA_FN:
+	case WEFT_DATA_FRAME:
+		return false;
+	case WEFT_DATA_BUILTIN:
+		return ((const Weft_Builtin *)data.ptr)->binary;
+	default:
+		return true;
+	}
+}
+
+static bool is_lowerable(Weft_Data data)
+{
+	return data.type == WEFT_DATA_SHUFFLE || is_op(data);
+}
+
+static bool is_const(Weft_Data data)
+{
+	return data.type != WEFT_DATA_BUILTIN && is_op(data);
+}
+
+static unsigned get_run_len(const Weft_List *list)
+{
+	unsigned len = 0;
+	while (list && len < lower_limit && is_lowerable(list->car)) {
+		list = list->cdr;
+		len++;
+	}
+	return len;
+}
+
+static bool is_worth_lowering(const Weft_List *list, unsigned len)
+{
+	if (len < 2) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < len; i++, list = list->cdr) {
+		if (!is_const(list->car)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void *alloc_array(size_t count, size_t size)
+{
+	void *ptr = calloc(count ? count : 1, size);
+	if (!ptr) {
+		fprintf(stderr,
+		        "Failed to allocate %zu bytes: %s\n",
+		        (count ? count : 1) * size,
+		        strerror(errno));
+		exit(1);
+	}
+	return ptr;
+}
+
+static unsigned add_op(Weft_LowerState *L, Weft_Data data)
+{
+	unsigned value = L->in_count + L->op_count;
+	L->data[L->op_count++] = data;
+
+	return value;
+}
+
+static void simulate(Weft_LowerState *L, Weft_Data data)
+{
+	if (data.type == WEFT_DATA_SHUFFLE) {
+		const Weft_Shuffle *shuffle = data.ptr;
+		unsigned in_count = shuffle_get_in_count(shuffle);
+		unsigned out_count = shuffle_get_out_count(shuffle);
+		unsigned *top = &L->stack[L->height - in_count];
+		unsigned frame[in_count ? in_count : 1];
+
+		for (unsigned i = 0; i < in_count; i++) {
+			frame[i] = top[i];
+		}
+		for (unsigned i = 0; i < out_count; i++) {
+			top[i] = frame[shuffle_get_out(shuffle, i)];
+		}
+		L->height += out_count - in_count;
+	} else if (data.type == WEFT_DATA_BUILTIN) {
+		unsigned *arg = L->arg[L->op_count];
+		arg[0] = L->stack[L->height - 2];
+		arg[1] = L->stack[L->height - 1];
+		L->height -= 2;
+		L->stack[L->height++] = add_op(L, data);
+	} else {
+		L->stack[L->height++] = add_op(L, data);
+	}
+}
+
+static void set_last_use(Weft_LowerState *L)
+{
+	for (unsigned i = 0; i < L->op_count; i++) {
+		if (L->data[i].type == WEFT_DATA_BUILTIN) {
+			L->last[L->arg[i][0]] = i + 1;
+			L->last[L->arg[i][1]] = i + 1;
+		}
+	}
+	for (unsigned i = 0; i < L->height; i++) {
+		L->last[L->stack[i]] = UINT_MAX;
+	}
+}
+
+static unsigned alloc_reg(Weft_LowerState *L, unsigned value)
+{
+	unsigned reg = 0;
+	while (L->busy[reg]) {
+		reg++;
+	}
+
+	L->reg[value] = reg;
+	L->busy[reg] = L->last[value];
+
+	return reg;
+}
+
+static Weft_Frame *build_frame(Weft_LowerState *L)
+{
+	unsigned count = 0;
+	for (unsigned i = 0; i < L->op_count; i++) {
+		if (L->last[L->in_count + i] || L->data[i].type == WEFT_DATA_BUILTIN) {
+			count++;
+		}
+	}
+
+	Weft_Frame *frame = new_frame(count, L->height);
+	unsigned size = L->in_count;
+
+	for (unsigned i = 0; i < L->in_count; i++) {
+		L->reg[i] = i;
+		L->busy[i] = L->last[i];
+	}
+
+	Weft_FrameOp *op = frame->op;
+	for (unsigned i = 0; i < L->op_count; i++) {
+		unsigned value = L->in_count + i;
+		bool is_call = L->data[i].type == WEFT_DATA_BUILTIN;
+
+		if (!is_call && !L->last[value]) {
+			continue;
+		} else if (is_call) {
+			for (unsigned j = 0; j < 2; j++) {
+				unsigned arg = L->arg[i][j];
+				op->arg[j] = L->reg[arg];
+				if (L->last[arg] == i + 1) {
+					L->busy[L->reg[arg]] = false;
+				}
+			}
+		}
+
+		op->data = L->data[i];
+		op->dst = alloc_reg(L, value);
+		if (op->dst >= size) {
+			size = op->dst + 1;
+		}
+		op++;
+	}
+
+	for (unsigned i = 0; i < L->height; i++) {
+		frame->out[i] = L->reg[L->stack[i]];
+	}
+	frame->in_count = L->in_count;
+	frame->size = size;
+
+	return frame;
+}
+
+static Weft_Frame *lower_run(const Weft_List *src, unsigned len)
+{
+	Weft_Effect effect = effect_known(0, 0);
+	unsigned bound = 0;
+
+	const Weft_List *list = src;
+	for (unsigned i = 0; i < len; i++, list = list->cdr) {
+		Weft_Data data = list->car;
+		effect = effect_then(effect, effect_of_data(data));
+		if (data.type == WEFT_DATA_SHUFFLE) {
+			bound += shuffle_get_out_count(data.ptr);
+		} else {
+			bound++;
+		}
+	}
+
+	Weft_LowerState L = {
+		.in_count = effect.in,
+		.op_count = 0,
+		.height = effect.in,
+	};
+	unsigned value_count = effect.in + len;
+
+	L.stack = alloc_array(effect.in + bound, sizeof(unsigned));
+	L.data = alloc_array(len, sizeof(Weft_Data));
+	L.arg = alloc_array(len, sizeof(*L.arg));
+	L.last = alloc_array(value_count, sizeof(unsigned));
+	L.reg = alloc_array(value_count, sizeof(unsigned));
+	L.busy = alloc_array(value_count, sizeof(bool));
+
+	for (unsigned i = 0; i < L.in_count; i++) {
+		L.stack[i] = i;
+	}
+	list = src;
+	for (unsigned i = 0; i < len; i++, list = list->cdr) {
+		simulate(&L, list->car);
+	}
+	set_last_use(&L);
+
+	Weft_Frame *frame = build_frame(&L);
+	frame->src = src;
+	frame->len = len;
+
+	free(L.stack);
+	free(L.data);
+	free(L.arg);
+	free(L.last);
+	free(L.reg);
+	free(L.busy);
+
+	return frame;
+}
+
+static bool has_lowerable(const Weft_List *list)
+{
+	while (list) {
+		unsigned len = get_run_len(list);
+		if (is_worth_lowering(list, len)) {
+			return true;
+		}
+		list = list->cdr;
+	}
+	return false;
+}
+
+Weft_List *lower_list(Weft_List *list)
+{
+	if (!lower_limit || !has_lowerable(list)) {
+		return list;
+	}
+
+	Weft_List *dest = NULL;
+	Weft_List *node = NULL;
+
+	while (list) {
+		Weft_Data data = list->car;
+		unsigned len = get_run_len(list);
+
+		if (is_worth_lowering(list, len)) {
+			data = data_frame(lower_run(list, len));
+			for (unsigned i = 0; i < len; i++) {
+				list = list->cdr;
+			}
+		} else {
+			list = list->cdr;
+		}
+
+		Weft_List *next = new_list_node(data, NULL);
+		if (node) {
+			node->cdr = next;
+		} else {
+			dest = next;
+		}
+		node = next;
+	}
+	return dest;
+}
+
+Weft_List *lower_fn(Weft_Fn *fn)
+{
+	if (!fn->code) {
+		fn->code = lower_list(compile_fn(fn));
+	}
+	return fn->code;
+}
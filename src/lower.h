@@ -0,0 +1,16 @@
+#ifndef WEFT_LOWER_H
+#define WEFT_LOWER_H
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_fn Weft_Fn;
+
+// Functions
+
+void lower_set_limit(unsigned limit);
+unsigned lower_get_limit(void);
+Weft_List *lower_list(Weft_List *list);
+Weft_List *lower_fn(Weft_Fn *fn);
+
+#endif
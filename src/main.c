@@ -1,19 +1,47 @@
+#include "buf.h"
+#include "builtin.h"
+#include "cache.h"
 #include "compile.h"
+#include "data.h"
+#include "effect.h"
+#include "emit.h"
 #include "eval.h"
+#include "fold.h"
+#include "gc.h"
+#include "image.h"
+#include "inline.h"
+#include "intern.h"
+#include "jit.h"
 #include "list.h"
+#include "lower.h"
+#include "memo.h"
 #include "parse.h"
+#include "prune.h"
+#include "serial.h"
+#include "thread.h"
 
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main(int argc, char **args)
+static bool compile_file(Weft_List **ctrl_p,
+                         Weft_Map **map_p,
+                         const char *path,
+                         const char *cache_dir,
+                         bool lazy,
+                         bool strip)
 {
-	if (argc < 2) {
-		return 0;
-	}
-
-	Weft_ParseFile *file = parse_file_load(args[1]);
+	Weft_ParseFile *file = parse_file_load(path);
 	if (!file) {
-		return 0;
+		return false;
+	} else if (cache_dir
+	           && cache_load(ctrl_p,
+	                         map_p,
+	                         builtin_get_map(),
+	                         cache_dir,
+	                         file->src)) {
+		return true;
 	}
 
 	Weft_ParseState P;
@@ -23,13 +51,142 @@ int main(int argc, char **args)
 
 	Weft_CompileState C;
 	compile_init(&C);
-	Weft_List *ctrl = compile(&C, pl);
+	C.lazy = lazy && !cache_dir;
+	*ctrl_p = compile(&C, pl);
+	*map_p = C.map;
 	compile_exit(&C);
 
+	if (strip || cache_dir) {
+		*map_p = prune(*ctrl_p, *map_p);
+	}
+	if (cache_dir && !parse_get_error_count()) {
+		cache_store(cache_dir, file->src, *ctrl_p, *map_p);
+	}
+	if (strip || cache_dir) {
+		intern_sweep();
+		gc_collect();
+	}
+	return true;
+}
+
+static int run(Weft_List *ctrl,
+               Weft_Map *map,
+               const char *in_path,
+               const char *out_path)
+{
 	Weft_EvalState W;
 	eval_init(&W);
-	eval(&W, ctrl);
+
+	if (in_path && !serial_load(&W.stack, map, in_path)) {
+		eval_exit(&W);
+		return 1;
+	}
+
+	if (!eval(&W, ctrl)) {
+		eval_exit(&W);
+		return 1;
+	}
+
+	if (out_path) {
+		size_t count = buf_get_at(W.stack) / sizeof(Weft_Data);
+		if (!serial_save(
+				out_path, buf_peek(W.stack, buf_get_at(W.stack)), count)) {
+			eval_exit(&W);
+			return 1;
+		}
+	}
 	eval_exit(&W);
 
 	return 0;
 }
+
+int main(int argc, char **args)
+{
+	const char *path = NULL;
+	const char *in_path = NULL;
+	const char *out_path = NULL;
+	const char *image_path = NULL;
+	const char *dump_path = NULL;
+	const char *emit_path = NULL;
+	const char *cache_dir = getenv("WEFT_CACHE_DIR");
+	bool check = false;
+	bool strip = false;
+	bool stats = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(args[i], "--in") && i + 1 < argc) {
+			in_path = args[++i];
+		} else if (!strcmp(args[i], "--out") && i + 1 < argc) {
+			out_path = args[++i];
+		} else if (!strcmp(args[i], "--image") && i + 1 < argc) {
+			image_path = args[++i];
+		} else if (!strcmp(args[i], "--dump-image") && i + 1 < argc) {
+			dump_path = args[++i];
+		} else if (!strcmp(args[i], "--emit-c") && i + 1 < argc) {
+			emit_path = args[++i];
+		} else if (!strcmp(args[i], "--cache") && i + 1 < argc) {
+			cache_dir = args[++i];
+		} else if (!strcmp(args[i], "--check")) {
+			check = true;
+		} else if (!strcmp(args[i], "--inline") && i + 1 < argc) {
+			inline_set_limit(strtoul(args[++i], NULL, 10));
+		} else if (!strcmp(args[i], "--fold") && i + 1 < argc) {
+			fold_set_limit(strtoul(args[++i], NULL, 10));
+		} else if (!strcmp(args[i], "--jit") && i + 1 < argc) {
+			jit_set_threshold(strtoul(args[++i], NULL, 10));
+		} else if (!strcmp(args[i], "--lower") && i + 1 < argc) {
+			lower_set_limit(strtoul(args[++i], NULL, 10));
+		} else if (!strcmp(args[i], "--memo") && i + 1 < argc) {
+			memo_set_limit(strtoul(args[++i], NULL, 10));
+		} else if (!strcmp(args[i], "--threads") && i + 1 < argc) {
+			thread_set_count(strtoul(args[++i], NULL, 10));
+		} else if (!strcmp(args[i], "--intern")) {
+			intern_set_enabled(true);
+		} else if (!strcmp(args[i], "--strip")) {
+			strip = true;
+		} else if (!strcmp(args[i], "--stats")) {
+			stats = true;
+		} else {
+			path = args[i];
+		}
+	}
+
+	Weft_List *ctrl;
+	Weft_Map *map;
+
+	if (image_path) {
+		if (!image_load(&ctrl, &map, builtin_get_map(), image_path)) {
+			return 1;
+		}
+	} else if (!path) {
+		return 0;
+	} else if (!compile_file(&ctrl,
+	                         &map,
+	                         path,
+	                         cache_dir,
+	                         !check && !dump_path,
+	                         !check && (strip || dump_path))) {
+		return 0;
+	}
+
+	if (check) {
+		if (!image_path && !in_path && !effect_check(ctrl)) {
+			return 1;
+		}
+		return parse_get_error_count() ? 1 : 0;
+	}
+	if (dump_path) {
+		return image_save(dump_path, ctrl, map) ? 0 : 1;
+	} else if (emit_path) {
+		return emit_c(emit_path, ctrl) ? 0 : 1;
+	}
+
+	int status = run(ctrl, map, in_path, out_path);
+	if (stats) {
+		fprintf(stderr, "buf reallocs: %zu\n", buf_get_realloc_count());
+		fprintf(stderr, "shared list nodes: %zu\n", intern_get_shared_count());
+		fprintf(stderr, "memo hits: %zu\n", memo_get_hit_count());
+		fprintf(stderr, "memo misses: %zu\n", memo_get_miss_count());
+	}
+	return status;
+}
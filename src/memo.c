@@ -0,0 +1,220 @@
+#include "memo.h"
+#include "data.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t memo_limit = 4096;
+static _Thread_local Weft_MemoEntry **bucket = NULL;
+static _Thread_local size_t bucket_cap = 0;
+static _Thread_local size_t memo_count = 0;
+static _Thread_local Weft_MemoEntry *head = NULL;
+static _Thread_local Weft_MemoEntry *tail = NULL;
+static _Thread_local size_t hit_count = 0;
+static _Thread_local size_t miss_count = 0;
+
+void memo_set_limit(size_t limit)
+{
+	memo_limit = limit;
+}
+
+static void *alloc_or_exit(size_t size)
+{
+	void *ptr = calloc(1, size);
+	if (!ptr) {
+		fprintf(stderr,
+		        "Failed to allocate %zu bytes: %s\n",
+		        size,
+		        strerror(errno));
+		exit(1);
+	}
+	return ptr;
+}
+
+static uint64_t
+hash_key(Weft_Data fn, const Weft_Data *in, unsigned in_count)
+{
+	uint64_t hash = data_hash(fn);
+	for (unsigned i = 0; i < in_count; i++) {
+		hash = data_hash_combine(hash, data_hash(in[i]));
+	}
+	return hash;
+}
+
+Weft_MemoEntry *new_memo_entry(Weft_Data fn,
+                               const Weft_Data *in,
+                               unsigned in_count,
+                               unsigned out_count)
+{
+	Weft_MemoEntry *entry = alloc_or_exit(
+		sizeof(Weft_MemoEntry) + (in_count + out_count) * sizeof(Weft_Data));
+	entry->hash = hash_key(fn, in, in_count);
+	entry->fn = fn;
+	entry->in_count = in_count;
+	entry->out_count = out_count;
+	memcpy(entry->data, in, in_count * sizeof(Weft_Data));
+
+	return entry;
+}
+
+Weft_MemoEntry *memo_entry_free(Weft_MemoEntry *entry)
+{
+	free(entry);
+	return NULL;
+}
+
+static bool is_match(const Weft_MemoEntry *entry,
+                     uint64_t hash,
+                     Weft_Data fn,
+                     const Weft_Data *in,
+                     unsigned in_count)
+{
+	if (entry->hash != hash || entry->in_count != in_count
+	    || !data_equal(entry->fn, fn)) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < in_count; i++) {
+		if (!data_equal(entry->data[i], in[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static Weft_MemoEntry **get_bucket(uint64_t hash)
+{
+	return &bucket[hash & (bucket_cap - 1)];
+}
+
+static Weft_MemoEntry *
+find_entry(uint64_t hash, Weft_Data fn, const Weft_Data *in, unsigned in_count)
+{
+	if (!bucket) {
+		return NULL;
+	}
+
+	Weft_MemoEntry *entry = *get_bucket(hash);
+	while (entry && !is_match(entry, hash, fn, in, in_count)) {
+		entry = entry->chain;
+	}
+	return entry;
+}
+
+static void unlink_entry(Weft_MemoEntry *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		tail = entry->prev;
+	}
+}
+
+static void push_entry(Weft_MemoEntry *entry)
+{
+	entry->prev = NULL;
+	entry->next = head;
+	if (head) {
+		head->prev = entry;
+	} else {
+		tail = entry;
+	}
+	head = entry;
+}
+
+const Weft_Data *
+memo_lookup(Weft_Data fn, const Weft_Data *in, unsigned in_count)
+{
+	Weft_MemoEntry *entry =
+		find_entry(hash_key(fn, in, in_count), fn, in, in_count);
+	if (!entry) {
+		miss_count++;
+		return NULL;
+	}
+
+	hit_count++;
+	unlink_entry(entry);
+	push_entry(entry);
+
+	return entry->data + entry->in_count;
+}
+
+static void evict_entry(void)
+{
+	Weft_MemoEntry *entry = tail;
+	Weft_MemoEntry **link = get_bucket(entry->hash);
+
+	while (*link != entry) {
+		link = &(*link)->chain;
+	}
+	*link = entry->chain;
+
+	unlink_entry(entry);
+	memo_entry_free(entry);
+	memo_count--;
+}
+
+void memo_insert(Weft_MemoEntry *entry, const Weft_Data *out)
+{
+	const Weft_Data *in = entry->data;
+	if (!memo_limit
+	    || find_entry(entry->hash, entry->fn, in, entry->in_count)) {
+		memo_entry_free(entry);
+		return;
+	}
+
+	if (!bucket) {
+		bucket_cap = 16;
+		while (bucket_cap < memo_limit) {
+			bucket_cap *= 2;
+		}
+		bucket = alloc_or_exit(bucket_cap * sizeof(Weft_MemoEntry *));
+	}
+	if (memo_count >= memo_limit) {
+		evict_entry();
+	}
+
+	memcpy(entry->data + entry->in_count,
+	       out,
+	       entry->out_count * sizeof(Weft_Data));
+
+	Weft_MemoEntry **link = get_bucket(entry->hash);
+	entry->chain = *link;
+	*link = entry;
+
+	push_entry(entry);
+	memo_count++;
+}
+
+void memo_clear(void)
+{
+	while (head) {
+		Weft_MemoEntry *next = head->next;
+		memo_entry_free(head);
+		head = next;
+	}
+	tail = NULL;
+	memo_count = 0;
+
+	free(bucket);
+	bucket = NULL;
+	bucket_cap = 0;
+}
+
+size_t memo_get_hit_count(void)
+{
+	return hit_count;
+}
+
+size_t memo_get_miss_count(void)
+{
+	return miss_count;
+}
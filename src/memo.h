@@ -0,0 +1,43 @@
+#ifndef WEFT_MEMO_H
+#define WEFT_MEMO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward Declarations
+
+typedef struct weft_memo_entry Weft_MemoEntry;
+
+// Local Includes
+
+#include "data.h"
+
+// Data Types
+
+struct weft_memo_entry {
+	uint64_t hash;
+	Weft_Data fn;
+	Weft_MemoEntry *chain;
+	Weft_MemoEntry *prev;
+	Weft_MemoEntry *next;
+	unsigned in_count;
+	unsigned out_count;
+	Weft_Data data[];
+};
+
+// Functions
+
+void memo_set_limit(size_t limit);
+Weft_MemoEntry *new_memo_entry(Weft_Data fn,
+                               const Weft_Data *in,
+                               unsigned in_count,
+                               unsigned out_count);
+Weft_MemoEntry *memo_entry_free(Weft_MemoEntry *entry);
+const Weft_Data *
+memo_lookup(Weft_Data fn, const Weft_Data *in, unsigned in_count);
+void memo_insert(Weft_MemoEntry *entry, const Weft_Data *out);
+void memo_clear(void);
+size_t memo_get_hit_count(void);
+size_t memo_get_miss_count(void);
+
+#endif
@@ -20,6 +20,10 @@ static const char shuffle_error_list[] = "{)]:;";
 #define FMT_ERROR "\e[91m"
 #define FMT_RESET "\e[0m"
 
+// Globals
+
+static size_t error_count;
+
 // Functions
 
 #define len_of(const_str) (sizeof(const_str) - 1)
@@ -56,7 +60,8 @@ Weft_ParseFile *parse_file_load(const char *path)
 
 	size_t src_len = file_len(f);
 	char *src = gc_alloc(src_len + 1);
-	fread(src, src_len, 1, f);
+	src_len = fread(src, 1, src_len, f);
+	src[src_len] = 0;
 	fclose(f);
 
 	return new_parse_file(copy_str(path), src);
@@ -363,6 +368,7 @@ void parse_error_v(Weft_ParseFile *file,
 	size_t line_no;
 	const char *line = get_line_at(&line_no, file->src, src);
 	size_t col_no = src - file->src;
+	error_count++;
 
 	print_error_msg(file->path, line_no, col_no, fmt, args);
 	print_error_line_left(line_no, col_no, line);
@@ -370,6 +376,11 @@ void parse_error_v(Weft_ParseFile *file,
 	print_error_line_right(src + len);
 }
 
+size_t parse_get_error_count(void)
+{
+	return error_count;
+}
+
 Weft_ParseToken parse_error_token(Weft_ParseFile *file,
                                   const char *src,
                                   size_t len,
@@ -1339,18 +1350,18 @@ static void pop_base(Weft_ParseState *P)
 
 static void push_list(Weft_ParseState *P)
 {
-	P->list_stack = buf_push(P->list_stack, &P->list, sizeof(Weft_ParseList *));
+	P->list_stack = buf_push_ptr(P->list_stack, P->list);
 	P->list = NULL;
 
-	P->node_stack = buf_push(P->node_stack, &P->node, sizeof(Weft_ParseList *));
+	P->node_stack = buf_push_ptr(P->node_stack, P->node);
 	P->node = NULL;
 }
 
 static Weft_ParseList *pop_list(Weft_ParseState *P)
 {
 	Weft_ParseList *list = P->list;
-	P->list_stack = buf_pop(&P->list, P->list_stack, sizeof(Weft_ParseList *));
-	P->node_stack = buf_pop(&P->node, P->node_stack, sizeof(Weft_ParseList *));
+	P->list_stack = buf_pop_ptr(&P->list, P->list_stack);
+	P->node_stack = buf_pop_ptr(&P->node, P->node_stack);
 
 	return list;
 }
@@ -1502,6 +1513,7 @@ static void handle_token(Weft_ParseState *P, Weft_ParseToken token)
 	case WEFT_PARSE_WORD:
 		return handle_word(P, token);
 	default:
+		flush_token_stack(P);
 		return output_token(P, token);
 	}
 }
@@ -95,6 +95,7 @@ void parse_error_v(Weft_ParseFile *file,
                    size_t len,
                    const char *fmt,
                    va_list args);
+size_t parse_get_error_count(void);
 Weft_ParseToken parse_empty(Weft_ParseFile *file, const char *src);
 Weft_ParseToken parse_token(Weft_ParseFile *file, const char *src);
 void parse_init(Weft_ParseState *P);
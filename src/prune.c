@@ -0,0 +1,200 @@
+#include "prune.h"
+#include "array.h"
+#include "buf.h"
+#include "builtin.h"
+#include "compile.h"
+#include "data.h"
+#include "dict.h"
+#include "fn.h"
+#include "gc.h"
+#include "list.h"
+#include "map.h"
+#include "pvec.h"
+#include "str.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+static Weft_Buf *push_list(Weft_Buf *pending, Weft_List *list)
+{
+	return buf_push_ptr(pending, list);
+}
+
+static Weft_Buf *mark_data(Weft_Buf *pending, Weft_Data data);
+
+static Weft_Buf *mark_array(Weft_Buf *pending, Weft_Array *array)
+{
+	gc_mark(array);
+
+	Weft_ArrayBuf *buf = array->buf;
+	if (gc_mark(buf)) {
+		return pending;
+	}
+
+	for (size_t i = 0; i < buf->len; i++) {
+		pending = mark_data(pending, buf->data[i]);
+	}
+	return pending;
+}
+
+static Weft_Buf *mark_dict(Weft_Buf *pending, Weft_Dict *dict)
+{
+	if (gc_mark(dict) || gc_mark(dict->buf)) {
+		return pending;
+	}
+
+	for (size_t i = 0; i < dict->buf->cap; i++) {
+		const Weft_DictEntry *entry = dict_buf_get_entry(dict->buf, i);
+		if (entry) {
+			pending = mark_data(pending, entry->key);
+			pending = mark_data(pending, entry->value);
+		}
+	}
+	return pending;
+}
+
+static void mark_str(Weft_Str *str)
+{
+	if (gc_mark(str)) {
+		return;
+	} else if (str->base) {
+		gc_mark(str->base);
+	}
+
+	if (str->left) {
+		mark_str(str->left);
+		mark_str(str->right);
+	}
+}
+
+static Weft_Buf *mark_leaf(Weft_Buf *pending, Weft_PVecLeaf *leaf)
+{
+	if (gc_mark(leaf)) {
+		return pending;
+	}
+
+	for (unsigned i = 0; i < leaf->count; i++) {
+		pending = mark_data(pending, leaf->data[i]);
+	}
+	return pending;
+}
+
+static Weft_Buf *mark_tree(Weft_Buf *pending, void *tree, unsigned shift)
+{
+	if (!shift) {
+		return mark_leaf(pending, tree);
+	}
+
+	Weft_PVecNode *node = tree;
+	if (gc_mark(node)) {
+		return pending;
+	}
+
+	for (unsigned i = 0; i < node->count; i++) {
+		pending = mark_tree(pending, node->child[i], shift - WEFT_PVEC_BITS);
+	}
+	return pending;
+}
+
+static Weft_Buf *mark_pvec(Weft_Buf *pending, Weft_PVec *pvec)
+{
+	if (gc_mark(pvec)) {
+		return pending;
+	} else if (pvec->tail) {
+		pending = mark_leaf(pending, pvec->tail);
+	}
+
+	if (pvec->root) {
+		pending = mark_tree(pending, pvec->root, pvec->shift);
+	}
+	return pending;
+}
+
+static Weft_Buf *mark_data(Weft_Buf *pending, Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_STR:
+		mark_str(data.ptr);
+		return pending;
+	case WEFT_DATA_SHUFFLE:
+	case WEFT_DATA_VEC:
+		gc_mark(data.ptr);
+		return pending;
+	case WEFT_DATA_BUILTIN:
+		builtin_mark(data.ptr);
+		return pending;
+	case WEFT_DATA_LIST:
+		return push_list(pending, data.ptr);
+	case WEFT_DATA_ARRAY:
+		return mark_array(pending, data.ptr);
+	case WEFT_DATA_PVEC:
+		return mark_pvec(pending, data.ptr);
+	case WEFT_DATA_DICT:
+		return mark_dict(pending, data.ptr);
+	case WEFT_DATA_FN:
+		if (gc_mark(data.ptr)) {
+			return pending;
+		}
+		fn_clear_code(data.ptr);
+		return push_list(pending, compile_fn(data.ptr));
+	default:
+		return pending;
+	}
+}
+
+static void mark_lists(Weft_Buf *pending)
+{
+	while (buf_get_at(pending)) {
+		Weft_List *list;
+		pending = buf_pop_ptr(&list, pending);
+
+		while (!gc_mark(list)) {
+			pending = mark_data(pending, list->car);
+			list = list->cdr;
+		}
+	}
+	buf_free(pending);
+}
+
+static Weft_Map *rebuild_map(Weft_Map *dest, Weft_Map *map)
+{
+	if (!map) {
+		return dest;
+	}
+
+	Weft_Data data = map_key_get_data(map->key);
+	if (data.type == WEFT_DATA_BUILTIN) {
+		dest = map_insert(dest, new_map_key_builtin(NULL, data.ptr));
+	} else if (gc_is_marked(data.ptr)) {
+		dest = map_insert(dest, new_map_key_fn(NULL, data.ptr));
+	}
+
+	dest = rebuild_map(dest, map->left);
+	return rebuild_map(dest, map->right);
+}
+
+void prune_mark_map(Weft_Map *map)
+{
+	if (!map || gc_mark(map)) {
+		return;
+	}
+
+	gc_mark(map->key);
+	prune_mark_map(map->key->map);
+	mark_lists(mark_data(new_buf(sizeof(Weft_List *)),
+	                     map_key_get_data(map->key)));
+
+	prune_mark_map(map->left);
+	prune_mark_map(map->right);
+}
+
+Weft_Map *prune(Weft_List *ctrl, Weft_Map *map)
+{
+	mark_lists(push_list(new_buf(sizeof(Weft_List *)), ctrl));
+
+	map = rebuild_map(NULL, map);
+	prune_mark_map(map);
+	prune_mark_map(builtin_get_map());
+
+	return map;
+}
@@ -0,0 +1,14 @@
+#ifndef WEFT_PRUNE_H
+#define WEFT_PRUNE_H
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_map Weft_Map;
+
+// Functions
+
+Weft_Map *prune(Weft_List *ctrl, Weft_Map *map);
+void prune_mark_map(Weft_Map *map);
+
+#endif
@@ -0,0 +1,651 @@
+#include "pvec.h"
+#include "gc.h"
+#include "list.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Constants
+
+static const unsigned PVEC_INVARIANT = 1;
+static const unsigned PVEC_EXTRA = 2;
+
+// Functions
+
+size_t pvec_leaf_get_size(unsigned count)
+{
+	return sizeof(Weft_PVecLeaf) + count * sizeof(Weft_Data);
+}
+
+size_t pvec_node_get_size(unsigned count)
+{
+	return sizeof(Weft_PVecNode) + count * (sizeof(void *) + sizeof(size_t));
+}
+
+size_t *pvec_node_get_sizes(const Weft_PVecNode *node)
+{
+	return (size_t *)(node->child + node->count);
+}
+
+static Weft_PVecLeaf *
+new_leaf(const Weft_Data *data, unsigned count, unsigned cap)
+{
+	Weft_PVecLeaf *leaf = gc_alloc(pvec_leaf_get_size(cap));
+	leaf->count = count;
+	leaf->cap = cap;
+	memcpy(leaf->data, data, count * sizeof(Weft_Data));
+
+	return leaf;
+}
+
+static size_t get_tree_size(const void *tree, unsigned shift)
+{
+	if (!tree) {
+		return 0;
+	} else if (!shift) {
+		return ((const Weft_PVecLeaf *)tree)->count;
+	}
+
+	const Weft_PVecNode *node = tree;
+	return pvec_node_get_sizes(node)[node->count - 1];
+}
+
+static Weft_PVecNode *
+new_node(void *const *child, unsigned count, unsigned shift)
+{
+	Weft_PVecNode *node = gc_alloc(pvec_node_get_size(count));
+	node->count = count;
+	node->shift = shift;
+	node->relaxed = false;
+	memcpy(node->child, child, count * sizeof(void *));
+
+	size_t *sizes = pvec_node_get_sizes(node);
+	size_t total = 0;
+
+	for (unsigned i = 0; i < count; i++) {
+		total += get_tree_size(child[i], shift - WEFT_PVEC_BITS);
+		sizes[i] = total;
+		if (i + 1 < count && total != (size_t)(i + 1) << shift) {
+			node->relaxed = true;
+		}
+	}
+	return node;
+}
+
+static Weft_PVec *new_pvec_from(size_t len,
+                                void *root,
+                                unsigned shift,
+                                Weft_PVecLeaf *tail,
+                                unsigned tail_len)
+{
+	while (shift && ((Weft_PVecNode *)root)->count == 1) {
+		root = ((Weft_PVecNode *)root)->child[0];
+		shift -= WEFT_PVEC_BITS;
+	}
+
+	Weft_PVec *pvec = gc_alloc(sizeof(Weft_PVec));
+	pvec->len = len;
+	pvec->shift = root ? shift : 0;
+	pvec->tail_len = tail_len;
+	pvec->root = root;
+	pvec->tail = tail_len ? tail : NULL;
+
+	return pvec;
+}
+
+Weft_PVec *new_pvec(void)
+{
+	return new_pvec_from(0, NULL, 0, NULL, 0);
+}
+
+Weft_PVec *pvec_from_data(const Weft_Data *data, size_t len)
+{
+	Weft_PVec *pvec = new_pvec();
+	for (size_t i = 0; i < len; i++) {
+		pvec = pvec_push(pvec, data[i]);
+	}
+	return pvec;
+}
+
+Weft_PVec *pvec_from_list(const Weft_List *list)
+{
+	Weft_PVec *pvec = new_pvec();
+	for (; list; list = list->cdr) {
+		pvec = pvec_push(pvec, list->car);
+	}
+	return pvec;
+}
+
+Weft_List *pvec_to_list(const Weft_PVec *pvec)
+{
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+
+	for (size_t i = 0; i < pvec->len;) {
+		size_t len;
+		const Weft_Data *data = pvec_get_chunk(pvec, i, &len);
+
+		for (size_t j = 0; j < len; j++) {
+			Weft_List *next = new_list_node(data[j], NULL);
+			if (node) {
+				node->cdr = next;
+			} else {
+				list = next;
+			}
+			node = next;
+		}
+		i += len;
+	}
+	return list;
+}
+
+size_t pvec_get_len(const Weft_PVec *pvec)
+{
+	return pvec->len;
+}
+
+static size_t get_tree_len(const Weft_PVec *pvec)
+{
+	return pvec->len - pvec->tail_len;
+}
+
+static unsigned
+locate(const Weft_PVecNode *node, size_t index, size_t *offset)
+{
+	const size_t *sizes = pvec_node_get_sizes(node);
+	unsigned slot = index >> node->shift;
+
+	if (node->relaxed) {
+		while (sizes[slot] <= index) {
+			slot++;
+		}
+	}
+
+	*offset = index - (slot ? sizes[slot - 1] : 0);
+	return slot;
+}
+
+static const Weft_PVecLeaf *
+find_leaf(const void *tree, unsigned shift, size_t index, size_t *offset)
+{
+	while (shift) {
+		const Weft_PVecNode *node = tree;
+		tree = node->child[locate(node, index, &index)];
+		shift -= WEFT_PVEC_BITS;
+	}
+
+	*offset = index;
+	return tree;
+}
+
+Weft_Data pvec_get(const Weft_PVec *pvec, size_t index)
+{
+	size_t len;
+	return *pvec_get_chunk(pvec, index, &len);
+}
+
+const Weft_Data *
+pvec_get_chunk(const Weft_PVec *pvec, size_t index, size_t *len)
+{
+	size_t tree_len = get_tree_len(pvec);
+	if (index >= tree_len) {
+		*len = pvec->len - index;
+		return pvec->tail->data + (index - tree_len);
+	}
+
+	size_t offset;
+	const Weft_PVecLeaf *leaf =
+		find_leaf(pvec->root, pvec->shift, index, &offset);
+
+	*len = leaf->count - offset;
+	return leaf->data + offset;
+}
+
+static void *
+set_tree(const void *tree, unsigned shift, size_t index, Weft_Data data)
+{
+	if (!shift) {
+		const Weft_PVecLeaf *leaf = tree;
+		Weft_PVecLeaf *copy = new_leaf(leaf->data, leaf->count, leaf->count);
+		copy->data[index] = data;
+
+		return copy;
+	}
+
+	const Weft_PVecNode *node = tree;
+	size_t size = pvec_node_get_size(node->count);
+	Weft_PVecNode *copy = gc_alloc(size);
+	memcpy(copy, node, size);
+
+	unsigned slot = locate(node, index, &index);
+	copy->child[slot] =
+		set_tree(node->child[slot], shift - WEFT_PVEC_BITS, index, data);
+
+	return copy;
+}
+
+Weft_PVec *pvec_set(const Weft_PVec *pvec, size_t index, Weft_Data data)
+{
+	size_t tree_len = get_tree_len(pvec);
+	void *root = pvec->root;
+	Weft_PVecLeaf *tail = pvec->tail;
+
+	if (index >= tree_len) {
+		tail = new_leaf(tail->data, pvec->tail_len, WEFT_PVEC_WIDTH);
+		tail->data[index - tree_len] = data;
+	} else {
+		root = set_tree(root, pvec->shift, index, data);
+	}
+	return new_pvec_from(pvec->len, root, pvec->shift, tail, pvec->tail_len);
+}
+
+static void *new_path(unsigned shift, Weft_PVecLeaf *leaf)
+{
+	void *tree = leaf;
+	for (unsigned at = WEFT_PVEC_BITS; at <= shift; at += WEFT_PVEC_BITS) {
+		tree = new_node(&tree, 1, at);
+	}
+	return tree;
+}
+
+static void *append_leaf(const void *tree, unsigned shift, Weft_PVecLeaf *leaf)
+{
+	if (!shift) {
+		return NULL;
+	}
+
+	const Weft_PVecNode *node = tree;
+	void *child[WEFT_PVEC_WIDTH];
+	unsigned count = node->count;
+	memcpy(child, node->child, count * sizeof(void *));
+
+	void *last = append_leaf(child[count - 1], shift - WEFT_PVEC_BITS, leaf);
+	if (last) {
+		child[count - 1] = last;
+	} else if (count < WEFT_PVEC_WIDTH) {
+		child[count++] = new_path(shift - WEFT_PVEC_BITS, leaf);
+	} else {
+		return NULL;
+	}
+	return new_node(child, count, shift);
+}
+
+static void *
+push_leaf(void *root, unsigned *shift_p, Weft_PVecLeaf *leaf)
+{
+	if (!root) {
+		*shift_p = 0;
+		return leaf;
+	}
+
+	void *tree = append_leaf(root, *shift_p, leaf);
+	if (tree) {
+		return tree;
+	}
+
+	void *child[2] = {root, new_path(*shift_p, leaf)};
+	*shift_p += WEFT_PVEC_BITS;
+
+	return new_node(child, 2, *shift_p);
+}
+
+static Weft_PVecLeaf *get_tail_leaf(const Weft_PVec *pvec)
+{
+	Weft_PVecLeaf *tail = pvec->tail;
+	if (tail->count == pvec->tail_len && tail->count == tail->cap) {
+		return tail;
+	}
+	return new_leaf(tail->data, pvec->tail_len, pvec->tail_len);
+}
+
+void pvec_seal(Weft_PVec *pvec)
+{
+	if (pvec->tail && pvec->tail->cap != pvec->tail->count) {
+		pvec->tail->cap = pvec->tail->count;
+	}
+}
+
+Weft_PVec *pvec_push(const Weft_PVec *pvec, Weft_Data data)
+{
+	Weft_PVecLeaf *tail = pvec->tail;
+	unsigned tail_len = pvec->tail_len;
+
+	if (tail && tail_len < WEFT_PVEC_WIDTH) {
+		if (tail->count != tail_len || tail->count == tail->cap) {
+			tail = new_leaf(tail->data, tail_len, WEFT_PVEC_WIDTH);
+		}
+		tail->data[tail->count++] = data;
+
+		return new_pvec_from(
+			pvec->len + 1, pvec->root, pvec->shift, tail, tail_len + 1);
+	}
+
+	void *root = pvec->root;
+	unsigned shift = pvec->shift;
+	if (tail) {
+		root = push_leaf(root, &shift, get_tail_leaf(pvec));
+	}
+
+	tail = new_leaf(&data, 1, WEFT_PVEC_WIDTH);
+	return new_pvec_from(pvec->len + 1, root, shift, tail, 1);
+}
+
+static unsigned get_count(const void *tree, unsigned shift)
+{
+	if (!shift) {
+		return ((const Weft_PVecLeaf *)tree)->count;
+	}
+	return ((const Weft_PVecNode *)tree)->count;
+}
+
+static unsigned
+plan_sizes(unsigned *size, void *const *child, unsigned count, unsigned shift)
+{
+	unsigned total = 0;
+	for (unsigned i = 0; i < count; i++) {
+		size[i] = get_count(child[i], shift);
+		total += size[i];
+	}
+
+	unsigned optimal = (total + WEFT_PVEC_WIDTH - 1) / WEFT_PVEC_WIDTH;
+	unsigned i = 0;
+
+	while (count > optimal + PVEC_EXTRA) {
+		while (size[i] > WEFT_PVEC_WIDTH - PVEC_INVARIANT) {
+			i++;
+		}
+
+		unsigned remaining = size[i];
+		do {
+			unsigned next = remaining + size[i + 1];
+			size[i] = (next < WEFT_PVEC_WIDTH) ? next : WEFT_PVEC_WIDTH;
+			remaining = next - size[i];
+			i++;
+		} while (remaining);
+
+		memmove(size + i, size + i + 1, (count - i - 1) * sizeof(unsigned));
+		count--;
+		i--;
+	}
+	return count;
+}
+
+static void *fill(void *const *child,
+                  unsigned *src_p,
+                  unsigned *offset_p,
+                  unsigned want,
+                  unsigned shift)
+{
+	Weft_Data data[WEFT_PVEC_WIDTH];
+	void *item[WEFT_PVEC_WIDTH];
+	unsigned filled = 0;
+
+	while (filled < want) {
+		const void *tree = child[*src_p];
+		unsigned count = get_count(tree, shift) - *offset_p;
+		if (count > want - filled) {
+			count = want - filled;
+		}
+
+		if (!shift) {
+			memcpy(data + filled,
+			       ((const Weft_PVecLeaf *)tree)->data + *offset_p,
+			       count * sizeof(Weft_Data));
+		} else {
+			memcpy(item + filled,
+			       ((const Weft_PVecNode *)tree)->child + *offset_p,
+			       count * sizeof(void *));
+		}
+
+		filled += count;
+		*offset_p += count;
+		if (*offset_p == get_count(tree, shift)) {
+			(*src_p)++;
+			*offset_p = 0;
+		}
+	}
+
+	if (!shift) {
+		return new_leaf(data, want, want);
+	}
+	return new_node(item, want, shift);
+}
+
+static unsigned rebalance(void **child, unsigned count, unsigned shift)
+{
+	unsigned size[2 * WEFT_PVEC_WIDTH];
+	unsigned len = plan_sizes(size, child, count, shift);
+	if (len == count) {
+		return count;
+	}
+
+	void *out[2 * WEFT_PVEC_WIDTH];
+	unsigned src = 0;
+	unsigned offset = 0;
+
+	for (unsigned i = 0; i < len; i++) {
+		if (!offset && get_count(child[src], shift) == size[i]) {
+			out[i] = child[src++];
+		} else {
+			out[i] = fill(child, &src, &offset, size[i], shift);
+		}
+	}
+
+	memcpy(child, out, len * sizeof(void *));
+	return len;
+}
+
+static unsigned
+pack(void **out, void *const *child, unsigned count, unsigned shift)
+{
+	unsigned first = (count < WEFT_PVEC_WIDTH) ? count : WEFT_PVEC_WIDTH;
+
+	out[0] = new_node(child, first, shift);
+	if (first == count) {
+		return 1;
+	}
+
+	out[1] = new_node(child + first, count - first, shift);
+	return 2;
+}
+
+static unsigned merge_leaves(void **out,
+                             const Weft_PVecLeaf *left,
+                             const Weft_PVecLeaf *right)
+{
+	Weft_Data data[2 * WEFT_PVEC_WIDTH];
+	unsigned count = left->count + right->count;
+
+	memcpy(data, left->data, left->count * sizeof(Weft_Data));
+	memcpy(data + left->count, right->data, right->count * sizeof(Weft_Data));
+
+	unsigned first = (count < WEFT_PVEC_WIDTH) ? count : WEFT_PVEC_WIDTH;
+	out[0] = new_leaf(data, first, first);
+	if (first == count) {
+		return 1;
+	}
+
+	out[1] = new_leaf(data + first, count - first, count - first);
+	return 2;
+}
+
+static unsigned merge(void **out,
+                      const void *left,
+                      unsigned left_shift,
+                      const void *right,
+                      unsigned right_shift)
+{
+	if (!left_shift && !right_shift) {
+		return merge_leaves(out, left, right);
+	}
+
+	const Weft_PVecNode *left_node = left;
+	const Weft_PVecNode *right_node = right;
+	void *child[2 * WEFT_PVEC_WIDTH];
+	unsigned count = 0;
+	unsigned shift;
+
+	if (left_shift > right_shift) {
+		shift = left_shift;
+		memcpy(child,
+		       left_node->child,
+		       (left_node->count - 1) * sizeof(void *));
+		count = left_node->count - 1;
+		count += merge(child + count,
+		               left_node->child[left_node->count - 1],
+		               shift - WEFT_PVEC_BITS,
+		               right,
+		               right_shift);
+	} else if (right_shift > left_shift) {
+		shift = right_shift;
+		count = merge(child,
+		              left,
+		              left_shift,
+		              right_node->child[0],
+		              shift - WEFT_PVEC_BITS);
+		memcpy(child + count,
+		       right_node->child + 1,
+		       (right_node->count - 1) * sizeof(void *));
+		count += right_node->count - 1;
+	} else {
+		shift = left_shift;
+		memcpy(child,
+		       left_node->child,
+		       (left_node->count - 1) * sizeof(void *));
+		count = left_node->count - 1;
+		count += merge(child + count,
+		               left_node->child[left_node->count - 1],
+		               shift - WEFT_PVEC_BITS,
+		               right_node->child[0],
+		               shift - WEFT_PVEC_BITS);
+		memcpy(child + count,
+		       right_node->child + 1,
+		       (right_node->count - 1) * sizeof(void *));
+		count += right_node->count - 1;
+	}
+
+	count = rebalance(child, count, shift - WEFT_PVEC_BITS);
+	return pack(out, child, count, shift);
+}
+
+Weft_PVec *pvec_cat(const Weft_PVec *left, const Weft_PVec *right)
+{
+	if (!left->len) {
+		return (Weft_PVec *)right;
+	} else if (!right->len) {
+		return (Weft_PVec *)left;
+	} else if (right->len <= WEFT_PVEC_WIDTH) {
+		Weft_PVec *pvec = (Weft_PVec *)left;
+		for (size_t i = 0; i < right->len; i++) {
+			pvec = pvec_push(pvec, pvec_get(right, i));
+		}
+		return pvec;
+	}
+
+	unsigned shift = left->shift;
+	void *root = left->root;
+	if (left->tail) {
+		root = push_leaf(root, &shift, get_tail_leaf(left));
+	}
+
+	void *out[2];
+	unsigned count = merge(out, root, shift, right->root, right->shift);
+
+	shift = (shift > right->shift) ? shift : right->shift;
+	root = out[0];
+	if (count > 1) {
+		shift += WEFT_PVEC_BITS;
+		root = new_node(out, count, shift);
+	}
+	return new_pvec_from(
+		left->len + right->len, root, shift, right->tail, right->tail_len);
+}
+
+static void *take(const void *tree, unsigned shift, size_t len)
+{
+	if (!shift) {
+		const Weft_PVecLeaf *leaf = tree;
+		return new_leaf(leaf->data, len, len);
+	}
+
+	const Weft_PVecNode *node = tree;
+	void *child[WEFT_PVEC_WIDTH];
+	size_t offset;
+	unsigned slot = locate(node, len - 1, &offset);
+
+	memcpy(child, node->child, slot * sizeof(void *));
+	child[slot] = take(node->child[slot], shift - WEFT_PVEC_BITS, offset + 1);
+
+	return new_node(child, slot + 1, shift);
+}
+
+static void *drop(const void *tree, unsigned shift, size_t len)
+{
+	if (!shift) {
+		const Weft_PVecLeaf *leaf = tree;
+		return new_leaf(leaf->data + len, leaf->count - len, leaf->count - len);
+	}
+
+	const Weft_PVecNode *node = tree;
+	void *child[WEFT_PVEC_WIDTH];
+	size_t offset;
+	unsigned slot = locate(node, len, &offset);
+	unsigned count = node->count - slot;
+
+	memcpy(child, node->child + slot, count * sizeof(void *));
+	if (offset) {
+		child[0] = drop(child[0], shift - WEFT_PVEC_BITS, offset);
+	}
+	return new_node(child, count, shift);
+}
+
+Weft_PVec *pvec_slice(const Weft_PVec *pvec, size_t start, size_t end)
+{
+	if (start == end) {
+		return new_pvec();
+	}
+
+	size_t tree_len = get_tree_len(pvec);
+	void *root = NULL;
+	unsigned shift = 0;
+
+	if (start < tree_len) {
+		root = pvec->root;
+		shift = pvec->shift;
+
+		if (end < tree_len) {
+			root = take(root, shift, end);
+		}
+		if (start) {
+			root = drop(root, shift, start);
+		}
+	}
+
+	Weft_PVecLeaf *tail = NULL;
+	unsigned tail_len = 0;
+
+	if (end > tree_len) {
+		size_t from = (start > tree_len) ? start - tree_len : 0;
+		tail_len = end - tree_len - from;
+		tail = new_leaf(pvec->tail->data + from, tail_len, WEFT_PVEC_WIDTH);
+	}
+	return new_pvec_from(end - start, root, shift, tail, tail_len);
+}
+
+void pvec_print(const Weft_PVec *pvec)
+{
+	printf("#p[");
+	for (size_t i = 0; i < pvec->len;) {
+		size_t len;
+		const Weft_Data *data = pvec_get_chunk(pvec, i, &len);
+
+		for (size_t j = 0; j < len; j++) {
+			if (i + j) {
+				printf(" ");
+			}
+			data_print(data[j]);
+		}
+		i += len;
+	}
+	printf("]");
+}
@@ -0,0 +1,66 @@
+#ifndef WEFT_PVEC_H
+#define WEFT_PVEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_pvec_leaf Weft_PVecLeaf;
+typedef struct weft_pvec_node Weft_PVecNode;
+typedef struct weft_pvec Weft_PVec;
+
+// Local Includes
+
+#include "data.h"
+
+// Data Types
+
+struct weft_pvec_leaf {
+	unsigned count;
+	unsigned cap;
+	Weft_Data data[];
+};
+
+struct weft_pvec_node {
+	unsigned count;
+	unsigned shift;
+	bool relaxed;
+	void *child[];
+};
+
+struct weft_pvec {
+	size_t len;
+	unsigned shift;
+	unsigned tail_len;
+	void *root;
+	Weft_PVecLeaf *tail;
+};
+
+// Constants
+
+static const unsigned WEFT_PVEC_BITS = 5;
+static const unsigned WEFT_PVEC_WIDTH = 32;
+
+// Functions
+
+Weft_PVec *new_pvec(void);
+Weft_PVec *pvec_from_data(const Weft_Data *data, size_t len);
+Weft_PVec *pvec_from_list(const Weft_List *list);
+Weft_List *pvec_to_list(const Weft_PVec *pvec);
+size_t pvec_get_len(const Weft_PVec *pvec);
+size_t *pvec_node_get_sizes(const Weft_PVecNode *node);
+size_t pvec_node_get_size(unsigned count);
+size_t pvec_leaf_get_size(unsigned count);
+Weft_Data pvec_get(const Weft_PVec *pvec, size_t index);
+const Weft_Data *
+pvec_get_chunk(const Weft_PVec *pvec, size_t index, size_t *len);
+Weft_PVec *pvec_set(const Weft_PVec *pvec, size_t index, Weft_Data data);
+void pvec_seal(Weft_PVec *pvec);
+Weft_PVec *pvec_push(const Weft_PVec *pvec, Weft_Data data);
+Weft_PVec *pvec_cat(const Weft_PVec *left, const Weft_PVec *right);
+Weft_PVec *pvec_slice(const Weft_PVec *pvec, size_t start, size_t end);
+void pvec_print(const Weft_PVec *pvec);
+
+#endif
@@ -0,0 +1,671 @@
+#include "serial.h"
+#include "array.h"
+#include "buf.h"
+#include "builtin.h"
+#include "dict.h"
+#include "file.h"
+#include "fn.h"
+#include "list.h"
+#include "map.h"
+#include "pvec.h"
+#include "shuffle.h"
+#include "str.h"
+#include "table.h"
+#include "vec.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Forward Declarations
+
+typedef struct weft_serial_reader Weft_SerialReader;
+
+// Data Types
+
+struct weft_serial_reader {
+	Weft_Map *map;
+	const char *src;
+	const char *end;
+	Weft_Buf *cells;
+	Weft_Buf *open;
+};
+
+// Constants
+
+enum {
+	CELL_END,
+	CELL_NEXT,
+	CELL_REF,
+};
+
+// Functions
+
+static Weft_Buf *write_byte(Weft_Buf *buf, uint8_t byte)
+{
+	return buf_push(buf, &byte, sizeof(uint8_t));
+}
+
+static Weft_Buf *write_uint(Weft_Buf *buf, uint64_t unum)
+{
+	uint8_t raw[10];
+	size_t len = 0;
+
+	while (unum >= 128) {
+		raw[len++] = (unum & 127) | 128;
+		unum >>= 7;
+	}
+	raw[len++] = unum;
+
+	return buf_push(buf, raw, len);
+}
+
+static uint64_t zigzag(long inum)
+{
+	return ((uint64_t)inum << 1) ^ (uint64_t)(inum >> (8 * sizeof(long) - 1));
+}
+
+static long unzigzag(uint64_t unum)
+{
+	return (long)(unum >> 1) ^ -(long)(unum & 1);
+}
+
+static Weft_Buf *write_float(Weft_Buf *buf, double fnum)
+{
+	uint64_t bits;
+	memcpy(&bits, &fnum, sizeof(double));
+
+	uint8_t raw[8];
+	for (unsigned i = 0; i < 8; i++) {
+		raw[i] = bits >> (8 * i);
+	}
+	return buf_push(buf, raw, 8);
+}
+
+static Weft_Buf *write_name(Weft_Buf *buf, const char *src, size_t len)
+{
+	buf = write_uint(buf, len);
+	return buf_push(buf, src, len);
+}
+
+static Weft_Buf *write_shuffle(Weft_Buf *buf, const Weft_Shuffle *shuffle)
+{
+	unsigned out_count = shuffle_get_out_count(shuffle);
+
+	buf = write_uint(buf, shuffle_get_in_count(shuffle));
+	buf = write_uint(buf, out_count);
+	for (unsigned i = 0; i < out_count; i++) {
+		buf = write_uint(buf, shuffle_get_out(shuffle, i));
+	}
+	return buf;
+}
+
+static Weft_Buf *
+write_data(Weft_Buf *buf, Weft_Table **cells_p, Weft_Data data);
+
+static Weft_Buf *
+write_array(Weft_Buf *buf, Weft_Table **cells_p, const Weft_Array *array)
+{
+	const Weft_Data *data = array_get_data(array);
+	size_t len = array_get_len(array);
+
+	buf = write_uint(buf, len);
+	for (size_t i = 0; i < len; i++) {
+		buf = write_data(buf, cells_p, data[i]);
+	}
+	return buf;
+}
+
+static Weft_Buf *
+write_pvec(Weft_Buf *buf, Weft_Table **cells_p, const Weft_PVec *pvec)
+{
+	buf = write_uint(buf, pvec_get_len(pvec));
+	for (size_t i = 0; i < pvec_get_len(pvec);) {
+		size_t len;
+		const Weft_Data *data = pvec_get_chunk(pvec, i, &len);
+
+		for (size_t j = 0; j < len; j++) {
+			buf = write_data(buf, cells_p, data[j]);
+		}
+		i += len;
+	}
+	return buf;
+}
+
+static Weft_Buf *
+write_dict(Weft_Buf *buf, Weft_Table **cells_p, const Weft_Dict *dict)
+{
+	buf = write_uint(buf, dict_get_len(dict));
+	for (size_t i = 0; i < dict_get_cap(dict); i++) {
+		const Weft_DictEntry *entry = dict_get_entry(dict, i);
+		if (entry) {
+			buf = write_data(buf, cells_p, entry->key);
+			buf = write_data(buf, cells_p, entry->value);
+		}
+	}
+	return buf;
+}
+
+static Weft_Buf *write_vec(Weft_Buf *buf, const Weft_Vec *vec)
+{
+	buf = write_byte(buf, vec->type);
+	buf = write_uint(buf, vec->len);
+
+	for (size_t i = 0; i < vec->len; i++) {
+		Weft_Data item = vec_get(vec, i);
+		switch (item.type) {
+		case WEFT_DATA_INT:
+			buf = write_uint(buf, zigzag(item.inum));
+			break;
+		case WEFT_DATA_FLOAT:
+			buf = write_float(buf, item.fnum);
+			break;
+		default:
+			buf = write_uint(buf, item.cnum);
+			break;
+		}
+	}
+	return buf;
+}
+
+static Weft_Buf *
+write_list(Weft_Buf *buf, Weft_Table **cells_p, const Weft_List *list)
+{
+	while (list) {
+		size_t index;
+		if (table_lookup(&index, *cells_p, list)) {
+			buf = write_byte(buf, CELL_REF);
+			return write_uint(buf, index);
+		}
+
+		*cells_p = table_insert(*cells_p, list, table_get_count(*cells_p));
+		buf = write_byte(buf, CELL_NEXT);
+		buf = write_data(buf, cells_p, list->car);
+		list = list->cdr;
+	}
+	return write_byte(buf, CELL_END);
+}
+
+static Weft_Buf *
+write_data(Weft_Buf *buf, Weft_Table **cells_p, Weft_Data data)
+{
+	buf = write_byte(buf, data.type);
+
+	switch (data.type) {
+	case WEFT_DATA_INT:
+		return write_uint(buf, zigzag(data.inum));
+	case WEFT_DATA_FLOAT:
+		return write_float(buf, data.fnum);
+	case WEFT_DATA_CHAR:
+		return write_uint(buf, data.cnum);
+	case WEFT_DATA_STR: {
+		const Weft_Str *str = data.ptr;
+		return write_name(buf, str_get_ch(str), str->len);
+	}
+	case WEFT_DATA_SHUFFLE:
+		return write_shuffle(buf, data.ptr);
+	case WEFT_DATA_LIST:
+		return write_list(buf, cells_p, data.ptr);
+	case WEFT_DATA_ARRAY:
+		return write_array(buf, cells_p, data.ptr);
+	case WEFT_DATA_VEC:
+		return write_vec(buf, data.ptr);
+	case WEFT_DATA_PVEC:
+		return write_pvec(buf, cells_p, data.ptr);
+	case WEFT_DATA_DICT:
+		return write_dict(buf, cells_p, data.ptr);
+	case WEFT_DATA_BUILTIN: {
+		const Weft_Builtin *builtin = data.ptr;
+		return write_name(buf, builtin->name, strlen(builtin->name));
+	}
+	case WEFT_DATA_FN: {
+		const Weft_Fn *fn = data.ptr;
+		return write_name(buf, fn->name, strlen(fn->name));
+	}
+	default:
+		return buf;
+	}
+}
+
+Weft_Buf *serial_write(Weft_Buf *buf, const Weft_Data *data, size_t count)
+{
+	buf = buf_push(buf, WEFT_SERIAL_MAGIC, sizeof(WEFT_SERIAL_MAGIC));
+	buf = write_uint(buf, WEFT_SERIAL_VERSION);
+	buf = write_uint(buf, count);
+
+	Weft_Table *cells = new_table(count);
+	for (size_t i = 0; i < count; i++) {
+		buf = write_data(buf, &cells, data[i]);
+	}
+	table_free(cells);
+
+	return buf;
+}
+
+static bool read_error(const char *msg)
+{
+	fprintf(stderr, "Failed to read serialized data: %s\n", msg);
+	return false;
+}
+
+static bool read_byte(uint8_t *byte, Weft_SerialReader *R)
+{
+	if (R->src >= R->end) {
+		return read_error("unexpected end of input");
+	}
+	*byte = *R->src++;
+
+	return true;
+}
+
+static bool read_uint(uint64_t *unum, Weft_SerialReader *R)
+{
+	*unum = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+		if (!read_byte(&byte, R)) {
+			return false;
+		}
+
+		*unum |= (uint64_t)(byte & 127) << shift;
+		if (!(byte & 128)) {
+			return true;
+		}
+	}
+	return read_error("varint too long");
+}
+
+static bool read_float(double *fnum, Weft_SerialReader *R)
+{
+	if (R->end - R->src < 8) {
+		return read_error("unexpected end of input");
+	}
+
+	uint64_t bits = 0;
+	for (unsigned i = 0; i < 8; i++) {
+		bits |= (uint64_t)(uint8_t)R->src[i] << (8 * i);
+	}
+	R->src += 8;
+	memcpy(fnum, &bits, sizeof(double));
+
+	return true;
+}
+
+static bool read_name(const char **src, size_t *len, Weft_SerialReader *R)
+{
+	uint64_t name_len;
+	if (!read_uint(&name_len, R)) {
+		return false;
+	} else if (name_len > (uint64_t)(R->end - R->src)) {
+		return read_error("unexpected end of input");
+	}
+
+	*src = R->src;
+	*len = name_len;
+	R->src += name_len;
+
+	return true;
+}
+
+static bool read_shuffle(Weft_Data *data, Weft_SerialReader *R)
+{
+	uint64_t in_count;
+	uint64_t out_count;
+	if (!read_uint(&in_count, R) || !read_uint(&out_count, R)) {
+		return false;
+	} else if (out_count > (uint64_t)(R->end - R->src)) {
+		return read_error("unexpected end of input");
+	}
+
+	Weft_Shuffle *shuffle = new_shuffle(in_count, out_count);
+	for (unsigned i = 0; i < out_count; i++) {
+		uint64_t out;
+		if (!read_uint(&out, R)) {
+			return false;
+		} else if (out >= in_count) {
+			return read_error("shuffle index out of range");
+		}
+		shuffle_set_out(shuffle, i, out);
+	}
+
+	*data = data_shuffle(shuffle);
+	return true;
+}
+
+static bool read_lookup(Weft_Data *data, Weft_SerialReader *R)
+{
+	const char *src;
+	size_t len;
+	if (!read_name(&src, &len, R)) {
+		return false;
+	}
+
+	Weft_MapKey *key = map_lookup_n(R->map, src, len);
+	if (!key) {
+		fprintf(stderr,
+		        "Failed to read serialized data: %.*s is undefined\n",
+		        (unsigned)len,
+		        src);
+		return false;
+	}
+
+	*data = map_key_get_data(key);
+	return true;
+}
+
+static bool read_data(Weft_Data *data, Weft_SerialReader *R);
+
+static bool is_open(const Weft_SerialReader *R, uint64_t index)
+{
+	size_t count = buf_get_at(R->open) / sizeof(size_t);
+	const size_t *open = buf_peek(R->open, buf_get_at(R->open));
+
+	size_t lo = 0;
+	size_t hi = count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (open[mid] < index) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo < count && open[lo] == index;
+}
+
+static bool read_list(Weft_Data *data, Weft_SerialReader *R)
+{
+	Weft_List *list = NULL;
+	Weft_List *node = NULL;
+	size_t own = 0;
+
+	while (true) {
+		uint8_t cell;
+		if (!read_byte(&cell, R)) {
+			return false;
+		}
+
+		Weft_List *next;
+		switch (cell) {
+		case CELL_END:
+			R->open = buf_drop(R->open, own * sizeof(size_t));
+			*data = data_list(list);
+			return true;
+		case CELL_REF: {
+			uint64_t index;
+			if (!read_uint(&index, R)) {
+				return false;
+			} else if (index >= buf_get_at(R->cells) / sizeof(Weft_List *)) {
+				return read_error("list reference out of range");
+			} else if (is_open(R, index)) {
+				return read_error("list reference to an unfinished cell");
+			}
+
+			Weft_List *const *cells = buf_peek(R->cells, buf_get_at(R->cells));
+			next = cells[index];
+			break;
+		}
+		case CELL_NEXT: {
+			size_t index = buf_get_at(R->cells) / sizeof(Weft_List *);
+			R->open = buf_push(R->open, &index, sizeof(index));
+			own++;
+
+			next = new_list_node(data_nil(), NULL);
+			R->cells = buf_push(R->cells, &next, sizeof(Weft_List *));
+			if (!read_data(&next->car, R)) {
+				return false;
+			}
+			break;
+		}
+		default:
+			return read_error("invalid list cell");
+		}
+
+		if (node) {
+			node->cdr = next;
+		} else {
+			list = next;
+		}
+		node = next;
+
+		if (cell == CELL_REF) {
+			R->open = buf_drop(R->open, own * sizeof(size_t));
+			*data = data_list(list);
+			return true;
+		}
+	}
+}
+
+static bool read_array(Weft_Data *data, Weft_SerialReader *R)
+{
+	uint64_t len;
+	if (!read_uint(&len, R)) {
+		return false;
+	} else if (len > (uint64_t)(R->end - R->src)) {
+		return read_error("unexpected end of input");
+	}
+
+	Weft_Array *array = new_array(len);
+	for (uint64_t i = 0; i < len; i++) {
+		Weft_Data item;
+		if (!read_data(&item, R)) {
+			return false;
+		}
+		array = array_push(array, item);
+	}
+
+	*data = data_array(array);
+	return true;
+}
+
+static bool read_pvec(Weft_Data *data, Weft_SerialReader *R)
+{
+	uint64_t len;
+	if (!read_uint(&len, R)) {
+		return false;
+	} else if (len > (uint64_t)(R->end - R->src)) {
+		return read_error("unexpected end of input");
+	}
+
+	Weft_PVec *pvec = new_pvec();
+	for (uint64_t i = 0; i < len; i++) {
+		Weft_Data item;
+		if (!read_data(&item, R)) {
+			return false;
+		}
+		pvec = pvec_push(pvec, item);
+	}
+
+	*data = data_pvec(pvec);
+	return true;
+}
+
+static bool read_dict(Weft_Data *data, Weft_SerialReader *R)
+{
+	uint64_t len;
+	if (!read_uint(&len, R)) {
+		return false;
+	} else if (len > (uint64_t)(R->end - R->src)) {
+		return read_error("unexpected end of input");
+	}
+
+	Weft_Dict *dict = new_dict(len);
+	for (uint64_t i = 0; i < len; i++) {
+		Weft_Data key;
+		Weft_Data value;
+		if (!read_data(&key, R) || !read_data(&value, R)) {
+			return false;
+		}
+		dict = dict_insert(dict, key, value);
+	}
+
+	*data = data_dict(dict);
+	return true;
+}
+
+static bool read_vec(Weft_Data *data, Weft_SerialReader *R)
+{
+	uint8_t type;
+	uint64_t len;
+	if (!read_byte(&type, R) || !read_uint(&len, R)) {
+		return false;
+	} else if (type > WEFT_VEC_U32) {
+		return read_error("invalid vector type");
+	} else if (len > (uint64_t)(R->end - R->src)) {
+		return read_error("unexpected end of input");
+	}
+
+	Weft_Vec *vec = new_vec(type, len);
+	for (uint64_t i = 0; i < len; i++) {
+		uint64_t unum;
+		double fnum;
+
+		if (type == WEFT_VEC_F64) {
+			if (!read_float(&fnum, R)) {
+				return false;
+			}
+			vec_set(vec, i, data_float(fnum));
+		} else if (!read_uint(&unum, R)) {
+			return false;
+		} else if (type == WEFT_VEC_I64) {
+			vec_set(vec, i, data_int(unzigzag(unum)));
+		} else {
+			vec_set(vec, i, data_char(unum));
+		}
+	}
+
+	*data = data_vec(vec);
+	return true;
+}
+
+static bool read_data(Weft_Data *data, Weft_SerialReader *R)
+{
+	uint8_t type;
+	if (!read_byte(&type, R)) {
+		return false;
+	}
+
+	uint64_t unum;
+	const char *src;
+	size_t len;
+
+	switch (type) {
+	case WEFT_DATA_NIL:
+		*data = data_nil();
+		return true;
+	case WEFT_DATA_INT:
+		if (!read_uint(&unum, R)) {
+			return false;
+		}
+		*data = data_int(unzigzag(unum));
+		return true;
+	case WEFT_DATA_FLOAT:
+		data->type = WEFT_DATA_FLOAT;
+		return read_float(&data->fnum, R);
+	case WEFT_DATA_CHAR:
+		if (!read_uint(&unum, R)) {
+			return false;
+		}
+		*data = data_char(unum);
+		return true;
+	case WEFT_DATA_STR:
+		if (!read_name(&src, &len, R)) {
+			return false;
+		}
+		*data = data_str(new_str_n(src, len));
+		return true;
+	case WEFT_DATA_SHUFFLE:
+		return read_shuffle(data, R);
+	case WEFT_DATA_LIST:
+		return read_list(data, R);
+	case WEFT_DATA_ARRAY:
+		return read_array(data, R);
+	case WEFT_DATA_VEC:
+		return read_vec(data, R);
+	case WEFT_DATA_PVEC:
+		return read_pvec(data, R);
+	case WEFT_DATA_DICT:
+		return read_dict(data, R);
+	case WEFT_DATA_BUILTIN:
+	case WEFT_DATA_FN:
+		return read_lookup(data, R);
+	default:
+		return read_error("invalid data type");
+	}
+}
+
+static bool read_header(uint64_t *count, Weft_SerialReader *R)
+{
+	if (R->end - R->src < sizeof(WEFT_SERIAL_MAGIC)
+	    || memcmp(R->src, WEFT_SERIAL_MAGIC, sizeof(WEFT_SERIAL_MAGIC))) {
+		return read_error("bad magic number");
+	}
+	R->src += sizeof(WEFT_SERIAL_MAGIC);
+
+	uint64_t version;
+	if (!read_uint(&version, R)) {
+		return false;
+	} else if (version != WEFT_SERIAL_VERSION) {
+		return read_error("unsupported version");
+	}
+	return read_uint(count, R);
+}
+
+bool serial_read(Weft_Buf **stack_p, Weft_Map *map, const char *src, size_t len)
+{
+	Weft_SerialReader R = {
+		.map = map,
+		.src = src,
+		.end = src + len,
+		.cells = new_buf(sizeof(Weft_List *)),
+		.open = new_buf(sizeof(size_t)),
+	};
+
+	uint64_t count;
+	bool ok = read_header(&count, &R);
+
+	for (uint64_t i = 0; ok && i < count; i++) {
+		Weft_Data data;
+		ok = read_data(&data, &R);
+		if (ok) {
+			*stack_p = buf_push_data(*stack_p, data);
+		}
+	}
+	buf_free(R.cells);
+	buf_free(R.open);
+
+	return ok;
+}
+
+bool serial_save(const char *path, const Weft_Data *data, size_t count)
+{
+	FILE *f = file_open(path, "wb");
+	if (!f) {
+		return false;
+	}
+
+	Weft_Buf *buf = serial_write(new_buf(sizeof(Weft_Data)), data, count);
+	bool ok = fwrite(buf_peek(buf, buf_get_at(buf)), buf_get_at(buf), 1, f)
+	       || !buf_get_at(buf);
+	buf_free(buf);
+	file_close(f);
+
+	if (!ok) {
+		fprintf(stderr, "Failed to write serialized data to '%s'\n", path);
+	}
+	return ok;
+}
+
+bool serial_load(Weft_Buf **stack_p, Weft_Map *map, const char *path)
+{
+	size_t len;
+	const char *src = file_map(path, &len);
+	if (!src) {
+		return false;
+	}
+
+	bool ok = serial_read(stack_p, map, src, len);
+	file_unmap(src, len);
+
+	return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef WEFT_SERIAL_H
+#define WEFT_SERIAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Forward Declarations
+
+typedef struct weft_buf Weft_Buf;
+typedef struct weft_map Weft_Map;
+
+// Local Includes
+
+#include "data.h"
+
+// Constants
+
+static const char WEFT_SERIAL_MAGIC[4] = {'W', 'F', 'T', 'D'};
+static const unsigned WEFT_SERIAL_VERSION = 1;
+
+// Functions
+
+Weft_Buf *serial_write(Weft_Buf *buf, const Weft_Data *data, size_t count);
+bool serial_read(Weft_Buf **stack_p,
+                 Weft_Map *map,
+                 const char *src,
+                 size_t len);
+bool serial_save(const char *path, const Weft_Data *data, size_t count);
+bool serial_load(Weft_Buf **stack_p, Weft_Map *map, const char *path);
+
+#endif
@@ -0,0 +1,214 @@
+#include "sort.h"
+#include "data.h"
+#include "str.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const unsigned RADIX_BITS = 8;
+static const unsigned RADIX_PASSES = 8;
+static const unsigned RADIX_MASK = 0xff;
+
+static Weft_Data *alloc_data(size_t len)
+{
+	Weft_Data *data = malloc(len * sizeof(Weft_Data));
+	if (!data) {
+		fprintf(stderr,
+		        "Failed to allocate %zu bytes: %s\n",
+		        len * sizeof(Weft_Data),
+		        strerror(errno));
+		exit(1);
+	}
+	return data;
+}
+
+static uint64_t get_key(Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_INT:
+		return (uint64_t)data.inum ^ (1ULL << 63);
+	case WEFT_DATA_CHAR:
+		return data.cnum;
+	default: {
+		uint64_t bits;
+		memcpy(&bits, &data.fnum, sizeof(bits));
+		return (bits >> 63) ? ~bits : bits | (1ULL << 63);
+	}
+	}
+}
+
+static void radix_sort(Weft_Data *data, size_t len)
+{
+	size_t count[RADIX_PASSES][RADIX_MASK + 1];
+	memset(count, 0, sizeof(count));
+
+	for (size_t i = 0; i < len; i++) {
+		uint64_t key = get_key(data[i]);
+		for (unsigned pass = 0; pass < RADIX_PASSES; pass++) {
+			count[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+		}
+	}
+
+	Weft_Data *tmp = alloc_data(len);
+	Weft_Data *src = data;
+	Weft_Data *dst = tmp;
+
+	for (unsigned pass = 0; pass < RADIX_PASSES; pass++) {
+		unsigned shift = pass * RADIX_BITS;
+		size_t *bucket = count[pass];
+		if (bucket[(get_key(src[0]) >> shift) & RADIX_MASK] == len) {
+			continue;
+		}
+
+		size_t sum = 0;
+		for (unsigned digit = 0; digit < RADIX_MASK + 1; digit++) {
+			size_t next = sum + bucket[digit];
+			bucket[digit] = sum;
+			sum = next;
+		}
+
+		for (size_t i = 0; i < len; i++) {
+			dst[bucket[(get_key(src[i]) >> shift) & RADIX_MASK]++] = src[i];
+		}
+
+		Weft_Data *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != data) {
+		memcpy(data, src, len * sizeof(Weft_Data));
+	}
+	free(tmp);
+}
+
+static bool merge(Weft_Data *dst,
+                  const Weft_Data *src,
+                  size_t start,
+                  size_t mid,
+                  size_t end,
+                  bool (*less)(bool *, void *, Weft_Data, Weft_Data),
+                  void *ctx)
+{
+	size_t left = start;
+	size_t right = mid;
+
+	for (size_t i = start; i < end; i++) {
+		bool take_right = left == mid;
+		if (!take_right && right < end
+		    && !less(&take_right, ctx, src[right], src[left])) {
+			return false;
+		}
+		dst[i] = take_right ? src[right++] : src[left++];
+	}
+	return true;
+}
+
+static size_t min_size(size_t left, size_t right)
+{
+	return left < right ? left : right;
+}
+
+bool sort_data_by(Weft_Data *data,
+                  size_t len,
+                  bool (*less)(bool *, void *, Weft_Data, Weft_Data),
+                  void *ctx)
+{
+	if (len < 2) {
+		return true;
+	}
+
+	Weft_Data *tmp = alloc_data(len);
+	Weft_Data *src = data;
+	Weft_Data *dst = tmp;
+	bool ok = true;
+
+	for (size_t width = 1; ok && width < len; width *= 2) {
+		for (size_t start = 0; ok && start < len; start += 2 * width) {
+			ok = merge(dst,
+			           src,
+			           start,
+			           min_size(start + width, len),
+			           min_size(start + 2 * width, len),
+			           less,
+			           ctx);
+		}
+
+		Weft_Data *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (ok && src != data) {
+		memcpy(data, src, len * sizeof(Weft_Data));
+	}
+	free(tmp);
+
+	return ok;
+}
+
+static bool is_number(Weft_Data data)
+{
+	return data.type == WEFT_DATA_INT || data.type == WEFT_DATA_FLOAT;
+}
+
+static double get_fnum(Weft_Data data)
+{
+	return data.type == WEFT_DATA_FLOAT ? data.fnum : data.inum;
+}
+
+static bool less_number(bool *less, void *ctx, Weft_Data left, Weft_Data right)
+{
+	if (left.type == WEFT_DATA_INT && right.type == WEFT_DATA_INT) {
+		*less = left.inum < right.inum;
+	} else {
+		*less = get_fnum(left) < get_fnum(right);
+	}
+	return true;
+}
+
+static bool less_str(bool *less, void *ctx, Weft_Data left, Weft_Data right)
+{
+	const Weft_Str *lstr = left.ptr;
+	const Weft_Str *rstr = right.ptr;
+	size_t len = min_size(lstr->len, rstr->len);
+
+	int cmp = memcmp(str_get_ch(lstr), str_get_ch(rstr), len);
+	*less = cmp < 0 || (!cmp && lstr->len < rstr->len);
+	return true;
+}
+
+bool sort_data(Weft_Data *data, size_t len)
+{
+	if (len < 2) {
+		return true;
+	}
+
+	bool same = true;
+	bool numeric = true;
+	for (size_t i = 0; i < len; i++) {
+		same = same && data[i].type == data[0].type;
+		numeric = numeric && is_number(data[i]);
+	}
+
+	if (numeric && !same) {
+		return sort_data_by(data, len, less_number, NULL);
+	} else if (!same) {
+		return false;
+	}
+
+	switch (data[0].type) {
+	case WEFT_DATA_INT:
+	case WEFT_DATA_FLOAT:
+	case WEFT_DATA_CHAR:
+		radix_sort(data, len);
+		return true;
+	case WEFT_DATA_STR:
+		return sort_data_by(data, len, less_str, NULL);
+	default:
+		return false;
+	}
+}
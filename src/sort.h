@@ -0,0 +1,19 @@
+#ifndef WEFT_SORT_H
+#define WEFT_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Local Includes
+
+#include "data.h"
+
+// Functions
+
+bool sort_data(Weft_Data *data, size_t len);
+bool sort_data_by(Weft_Data *data,
+                  size_t len,
+                  bool (*less)(bool *, void *, Weft_Data, Weft_Data),
+                  void *ctx);
+
+#endif
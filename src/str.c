@@ -6,15 +6,137 @@
 #include <stdio.h>
 #include <string.h>
 
-Weft_Str *new_str_n(const char *src, size_t len)
+static Weft_Str *new_str(size_t len)
 {
 	Weft_Str *str = gc_alloc(sizeof(Weft_Str) + len + 1);
-	memcpy(str->ch, src, len);
-	str->ch[len] = 0;
+	str->len = len;
+	str->depth = 0;
+	str->ch = str->data;
+	str->base = NULL;
+	str->left = NULL;
+	str->right = NULL;
+	str->data[len] = 0;
+
+	return str;
+}
+
+Weft_Str *new_str_n(const char *src, size_t len)
+{
+	Weft_Str *str = new_str(len);
+	memcpy(str->data, src, len);
 
 	return str;
 }
 
+static Weft_Str *new_view(Weft_Str *base, const char *ch, size_t len)
+{
+	Weft_Str *str = gc_alloc(sizeof(Weft_Str));
+	str->len = len;
+	str->depth = 0;
+	str->ch = ch;
+	str->base = base;
+	str->left = NULL;
+	str->right = NULL;
+
+	return str;
+}
+
+static Weft_Str *new_rope(Weft_Str *left, Weft_Str *right)
+{
+	Weft_Str *str = gc_alloc(sizeof(Weft_Str));
+	str->len = left->len + right->len;
+	str->depth = (left->depth > right->depth) ? left->depth : right->depth;
+	str->depth++;
+	str->ch = NULL;
+	str->base = NULL;
+	str->left = left;
+	str->right = right;
+
+	return str;
+}
+
+static char *copy_str(char *dest, const Weft_Str *str)
+{
+	if (str->ch) {
+		memcpy(dest, str->ch, str->len);
+		return dest + str->len;
+	}
+
+	dest = copy_str(dest, str->left);
+	return copy_str(dest, str->right);
+}
+
+const char *str_get_ch(const Weft_Str *str)
+{
+	if (str->ch) {
+		return str->ch;
+	}
+
+	Weft_Str *flat = new_str(str->len);
+	copy_str(flat->data, str);
+
+	Weft_Str *rope = (Weft_Str *)str;
+	rope->depth = 0;
+	rope->ch = flat->data;
+	rope->base = flat;
+	rope->left = NULL;
+	rope->right = NULL;
+
+	return rope->ch;
+}
+
+Weft_Str *str_get_flat(const Weft_Str *str)
+{
+	const char *ch = str_get_ch(str);
+	if (ch == str->data) {
+		return (Weft_Str *)str;
+	} else if (ch == str->base->data && str->len == str->base->len) {
+		return str->base;
+	}
+	return new_str_n(ch, str->len);
+}
+
+Weft_Str *str_slice(const Weft_Str *str, size_t start, size_t end)
+{
+	if (!start && end == str->len) {
+		return (Weft_Str *)str;
+	} else if (str->ch) {
+		Weft_Str *base = str->base ? str->base : (Weft_Str *)str;
+		return new_view(base, str->ch + start, end - start);
+	}
+
+	size_t split = str->left->len;
+	if (end <= split) {
+		return str_slice(str->left, start, end);
+	} else if (start >= split) {
+		return str_slice(str->right, start - split, end - split);
+	}
+	return str_cat(str_slice(str->left, start, split),
+	               str_slice(str->right, 0, end - split));
+}
+
+Weft_Str *str_cat(const Weft_Str *left, const Weft_Str *right)
+{
+	if (!left->len) {
+		return (Weft_Str *)right;
+	} else if (!right->len) {
+		return (Weft_Str *)left;
+	}
+
+	size_t len = left->len + right->len;
+	if (len < WEFT_STR_ROPE_MIN) {
+		Weft_Str *str = new_str(len);
+		copy_str(copy_str(str->data, left), right);
+		return str;
+	}
+
+	Weft_Str *str = new_rope((Weft_Str *)left, (Weft_Str *)right);
+	if (str->depth > WEFT_STR_ROPE_DEPTH) {
+		str_get_ch(str);
+	}
+	return str;
+}
+
 void str_print(const Weft_Str *str)
 {
 	printf("\"");
@@ -30,10 +152,10 @@ static bool is_span_char(char c)
 	return c == ' ' || char_is_utf8(c) || (isgraph(c) && !isspace(c));
 }
 
-static unsigned get_print_span(const char *ch)
+static unsigned get_print_span(const char *ch, const char *end)
 {
 	unsigned span = 0;
-	while (is_span_char(ch[span])) {
+	while (ch + span < end && is_span_char(ch[span])) {
 		span++;
 	}
 	return span;
@@ -41,9 +163,11 @@ static unsigned get_print_span(const char *ch)
 
 void str_print_bare(const Weft_Str *str)
 {
-	const char *ch = str->ch;
-	while (*ch) {
-		unsigned span = get_print_span(ch);
+	const char *ch = str_get_ch(str);
+	const char *end = ch + str->len;
+
+	while (ch < end) {
+		unsigned span = get_print_span(ch, end);
 		if (span) {
 			printf("%.*s", span, ch);
 			ch += span;
@@ -11,12 +11,26 @@ typedef struct weft_str Weft_Str;
 
 struct weft_str {
 	size_t len;
-	char ch[];
+	unsigned depth;
+	const char *ch;
+	Weft_Str *base;
+	Weft_Str *left;
+	Weft_Str *right;
+	char data[];
 };
 
+// Constants
+
+static const size_t WEFT_STR_ROPE_MIN = 64;
+static const unsigned WEFT_STR_ROPE_DEPTH = 48;
+
 // Functions
 
 Weft_Str *new_str_n(const char *src, size_t len);
+const char *str_get_ch(const Weft_Str *str);
+Weft_Str *str_get_flat(const Weft_Str *str);
+Weft_Str *str_slice(const Weft_Str *str, size_t start, size_t end);
+Weft_Str *str_cat(const Weft_Str *left, const Weft_Str *right);
 void str_print(const Weft_Str *str);
 void str_print_bare(const Weft_Str *str);
 
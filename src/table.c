@@ -0,0 +1,118 @@
+#include "table.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t round_cap(size_t cap)
+{
+	size_t pow = 8;
+	while (pow < cap) {
+		pow *= 2;
+	}
+	return pow;
+}
+
+Weft_Table *new_table(size_t cap)
+{
+	cap = round_cap(cap);
+
+	Weft_Table *table =
+		calloc(1, sizeof(Weft_Table) + cap * sizeof(Weft_TableEntry));
+	if (!table) {
+		fprintf(stderr,
+		        "Failed to allocate %zu bytes: %s\n",
+		        sizeof(Weft_Table) + cap * sizeof(Weft_TableEntry),
+		        strerror(errno));
+		exit(1);
+	}
+
+	table->cap = cap;
+	table->count = 0;
+
+	return table;
+}
+
+Weft_Table *table_free(Weft_Table *table)
+{
+	if (!table) {
+		return NULL;
+	}
+	free(table);
+
+	return NULL;
+}
+
+size_t table_get_count(const Weft_Table *table)
+{
+	return table->count;
+}
+
+static size_t hash_key(const void *key)
+{
+	uint64_t h = (uintptr_t)key;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+static Weft_TableEntry *find_entry(const Weft_Table *table, const void *key)
+{
+	size_t mask = table->cap - 1;
+	size_t index = hash_key(key) & mask;
+
+	while (table->entry[index].key && table->entry[index].key != key) {
+		index = (index + 1) & mask;
+	}
+	return (Weft_TableEntry *)&table->entry[index];
+}
+
+bool table_lookup(size_t *value, const Weft_Table *table, const void *key)
+{
+	Weft_TableEntry *entry = find_entry(table, key);
+	if (!entry->key) {
+		return false;
+	}
+
+	*value = entry->value;
+	return true;
+}
+
+static bool is_crowded(const Weft_Table *table)
+{
+	return 4 * (table->count + 1) > 3 * table->cap;
+}
+
+static Weft_Table *grow_table(Weft_Table *table)
+{
+	Weft_Table *grown = new_table(2 * table->cap);
+	for (size_t i = 0; i < table->cap; i++) {
+		if (table->entry[i].key) {
+			*find_entry(grown, table->entry[i].key) = table->entry[i];
+			grown->count++;
+		}
+	}
+	table_free(table);
+
+	return grown;
+}
+
+Weft_Table *table_insert(Weft_Table *table, const void *key, size_t value)
+{
+	if (is_crowded(table)) {
+		table = grow_table(table);
+	}
+
+	Weft_TableEntry *entry = find_entry(table, key);
+	if (!entry->key) {
+		entry->key = key;
+		table->count++;
+	}
+	entry->value = value;
+
+	return table;
+}
@@ -0,0 +1,33 @@
+#ifndef WEFT_TABLE_H
+#define WEFT_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Forward Declarations
+
+typedef struct weft_table_entry Weft_TableEntry;
+typedef struct weft_table Weft_Table;
+
+// Data Types
+
+struct weft_table_entry {
+	const void *key;
+	size_t value;
+};
+
+struct weft_table {
+	size_t cap;
+	size_t count;
+	Weft_TableEntry entry[];
+};
+
+// Functions
+
+Weft_Table *new_table(size_t cap);
+Weft_Table *table_free(Weft_Table *table);
+size_t table_get_count(const Weft_Table *table);
+bool table_lookup(size_t *value, const Weft_Table *table, const void *key);
+Weft_Table *table_insert(Weft_Table *table, const void *key, size_t value);
+
+#endif
@@ -0,0 +1,248 @@
+#include "thread.h"
+#include "array.h"
+#include "compile.h"
+#include "data.h"
+#include "dict.h"
+#include "effect.h"
+#include "eval.h"
+#include "fn.h"
+#include "frame.h"
+#include "gc.h"
+#include "list.h"
+#include "lower.h"
+#include "memo.h"
+#include "pvec.h"
+#include "str.h"
+#include "table.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Forward Declarations
+
+typedef struct weft_thread_job Weft_ThreadJob;
+typedef struct weft_thread_worker Weft_ThreadWorker;
+
+// Data Types
+
+struct weft_thread_job {
+	Weft_Data fn;
+	const Weft_Data *in;
+	Weft_Data *out;
+	size_t len;
+	atomic_size_t next;
+	atomic_bool failed;
+};
+
+struct weft_thread_worker {
+	pthread_t thread;
+	Weft_ThreadJob *job;
+	Weft_GC *heap;
+};
+
+// Globals
+
+static unsigned thread_count = 0;
+
+// Functions
+
+void thread_set_count(unsigned count)
+{
+	thread_count = count;
+}
+
+static unsigned get_thread_count(void)
+{
+	if (thread_count) {
+		return thread_count;
+	}
+
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	return online > 0 ? online : 1;
+}
+
+static bool is_seen(Weft_Table **seen_p, const void *ptr)
+{
+	size_t value;
+	if (!ptr || table_lookup(&value, *seen_p, ptr)) {
+		return true;
+	}
+
+	*seen_p = table_insert(*seen_p, ptr, 1);
+	return false;
+}
+
+static void freeze_data(Weft_Table **seen_p, Weft_Data data);
+
+static void freeze_list(Weft_Table **seen_p, const Weft_List *list)
+{
+	for (; !is_seen(seen_p, list); list = list->cdr) {
+		freeze_data(seen_p, list->car);
+	}
+}
+
+static void freeze_fn(Weft_Table **seen_p, Weft_Fn *fn)
+{
+	effect_of_fn(fn);
+	freeze_list(seen_p, compile_fn(fn));
+	freeze_list(seen_p, lower_fn(fn));
+	freeze_list(seen_p, fn->rest);
+}
+
+static void freeze_object(Weft_Table **seen_p, Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_STR:
+		str_get_ch(data.ptr);
+		break;
+	case WEFT_DATA_FN:
+		freeze_fn(seen_p, data.ptr);
+		break;
+	case WEFT_DATA_FRAME:
+		freeze_list(seen_p, ((const Weft_Frame *)data.ptr)->src);
+		break;
+	case WEFT_DATA_ARRAY:
+		array_seal(data.ptr);
+		for (size_t i = 0; i < array_get_len(data.ptr); i++) {
+			freeze_data(seen_p, array_get(data.ptr, i));
+		}
+		break;
+	case WEFT_DATA_PVEC:
+		pvec_seal(data.ptr);
+		for (size_t i = 0; i < pvec_get_len(data.ptr); i++) {
+			freeze_data(seen_p, pvec_get(data.ptr, i));
+		}
+		break;
+	case WEFT_DATA_DICT: {
+		Weft_Dict *dict = data.ptr;
+		dict_seal(dict);
+		for (size_t i = 0; i < dict_get_cap(dict); i++) {
+			const Weft_DictEntry *entry = dict_get_entry(dict, i);
+			if (entry) {
+				freeze_data(seen_p, entry->key);
+				freeze_data(seen_p, entry->value);
+			}
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void freeze_data(Weft_Table **seen_p, Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_LIST:
+		freeze_list(seen_p, data.ptr);
+		break;
+	case WEFT_DATA_STR:
+	case WEFT_DATA_FN:
+	case WEFT_DATA_FRAME:
+	case WEFT_DATA_ARRAY:
+	case WEFT_DATA_PVEC:
+	case WEFT_DATA_DICT:
+		if (!is_seen(seen_p, data.ptr)) {
+			freeze_object(seen_p, data);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static bool run_item(Weft_EvalState *W, Weft_ThreadJob *job, size_t i)
+{
+	eval_reset(W);
+	eval_push(W, job->in[i]);
+
+	if (!eval_apply(W, job->fn)) {
+		return false;
+	} else if (eval_get_depth(W) != 1) {
+		return eval_error(W, "pmap: quotation must leave one value");
+	}
+
+	job->out[i] = eval_pop(W);
+	return true;
+}
+
+static void *run_worker(void *arg)
+{
+	Weft_ThreadWorker *worker = arg;
+	Weft_ThreadJob *job = worker->job;
+
+	Weft_EvalState W;
+	eval_init(&W);
+	W.shared = true;
+
+	while (!atomic_load(&job->failed)) {
+		size_t i = atomic_fetch_add(&job->next, 1);
+		if (i >= job->len) {
+			break;
+		} else if (!run_item(&W, job, i)) {
+			atomic_store(&job->failed, true);
+		}
+	}
+
+	eval_exit(&W);
+	memo_clear();
+	worker->heap = gc_detach();
+
+	return NULL;
+}
+
+bool thread_map(Weft_Data *out, const Weft_Data *in, size_t len, Weft_Data fn)
+{
+	Weft_Table *seen = new_table(64);
+	freeze_data(&seen, fn);
+	for (size_t i = 0; i < len; i++) {
+		freeze_data(&seen, in[i]);
+	}
+	table_free(seen);
+
+	Weft_ThreadJob job = {
+		.fn = fn,
+		.in = in,
+		.out = out,
+		.len = len,
+	};
+	atomic_init(&job.next, 0);
+	atomic_init(&job.failed, false);
+
+	unsigned count = get_thread_count();
+	if (count > len) {
+		count = len;
+	}
+
+	Weft_ThreadWorker *worker = calloc(count, sizeof(Weft_ThreadWorker));
+	if (count && !worker) {
+		fprintf(stderr,
+		        "Failed to allocate %zu bytes: %s\n",
+		        count * sizeof(Weft_ThreadWorker),
+		        strerror(errno));
+		exit(1);
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		worker[i].job = &job;
+		int err =
+			pthread_create(&worker[i].thread, NULL, run_worker, &worker[i]);
+		if (err) {
+			fprintf(stderr, "Failed to start thread: %s\n", strerror(err));
+			exit(1);
+		}
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		pthread_join(worker[i].thread, NULL);
+		gc_attach(worker[i].heap);
+	}
+	free(worker);
+
+	return !atomic_load(&job.failed);
+}
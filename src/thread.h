@@ -0,0 +1,16 @@
+#ifndef WEFT_THREAD_H
+#define WEFT_THREAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Local Includes
+
+#include "data.h"
+
+// Functions
+
+void thread_set_count(unsigned count);
+bool thread_map(Weft_Data *out, const Weft_Data *in, size_t len, Weft_Data fn);
+
+#endif
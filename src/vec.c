@@ -0,0 +1,883 @@
+#include "vec.h"
+#include "char.h"
+#include "gc.h"
+#include "list.h"
+#include "str.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#define WEFT_VEC_AVX2
+#define WEFT_VEC_SIMD
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define WEFT_VEC_SSE2
+#define WEFT_VEC_SIMD
+#include <emmintrin.h>
+#endif
+
+// Forward Declarations
+
+typedef union weft_vec_scalar Weft_VecScalar;
+
+// Data Types
+
+union weft_vec_scalar {
+	long i64;
+	double f64;
+	uint32_t u32;
+};
+
+// Constants
+
+#if defined(WEFT_VEC_AVX2)
+#define F64_LANES 4
+#define I64_LANES 4
+#define U32_LANES 8
+typedef __m256d Weft_F64x;
+typedef __m256i Weft_IntX;
+#elif defined(WEFT_VEC_SSE2)
+#define F64_LANES 2
+#define I64_LANES 2
+#define U32_LANES 4
+typedef __m128d Weft_F64x;
+typedef __m128i Weft_IntX;
+#endif
+
+// Functions
+
+#if defined(WEFT_VEC_AVX2)
+static Weft_F64x f64x_load(const double *src, size_t step)
+{
+	return step ? _mm256_loadu_pd(src) : _mm256_set1_pd(*src);
+}
+
+static void f64x_store(double *dst, Weft_F64x x)
+{
+	_mm256_storeu_pd(dst, x);
+}
+
+static Weft_F64x f64x_apply(Weft_VecOp op, Weft_F64x x, Weft_F64x y)
+{
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return _mm256_add_pd(x, y);
+	case WEFT_VEC_SUB:
+		return _mm256_sub_pd(x, y);
+	case WEFT_VEC_MUL:
+		return _mm256_mul_pd(x, y);
+	case WEFT_VEC_DIV:
+		return _mm256_div_pd(x, y);
+	case WEFT_VEC_LT:
+		return _mm256_and_pd(_mm256_cmp_pd(x, y, _CMP_LT_OQ),
+		                     _mm256_set1_pd(1.0));
+	case WEFT_VEC_EQ:
+		return _mm256_and_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ),
+		                     _mm256_set1_pd(1.0));
+	}
+	return x;
+}
+
+static Weft_F64x f64x_pick(bool max, Weft_F64x x, Weft_F64x y)
+{
+	return max ? _mm256_max_pd(x, y) : _mm256_min_pd(x, y);
+}
+
+static Weft_IntX intx_load(const void *src)
+{
+	return _mm256_loadu_si256(src);
+}
+
+static void intx_store(void *dst, Weft_IntX x)
+{
+	_mm256_storeu_si256(dst, x);
+}
+
+static Weft_IntX i64x_load(const long *src, size_t step)
+{
+	return step ? intx_load(src) : _mm256_set1_epi64x(*src);
+}
+
+static bool i64x_supports(Weft_VecOp op)
+{
+	return op != WEFT_VEC_MUL && op != WEFT_VEC_DIV;
+}
+
+static Weft_IntX i64x_apply(Weft_VecOp op, Weft_IntX x, Weft_IntX y)
+{
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return _mm256_add_epi64(x, y);
+	case WEFT_VEC_SUB:
+		return _mm256_sub_epi64(x, y);
+	case WEFT_VEC_LT:
+		return _mm256_and_si256(_mm256_cmpgt_epi64(y, x),
+		                        _mm256_set1_epi64x(1));
+	case WEFT_VEC_EQ:
+		return _mm256_and_si256(_mm256_cmpeq_epi64(x, y),
+		                        _mm256_set1_epi64x(1));
+	default:
+		return x;
+	}
+}
+
+static Weft_IntX i64x_pick(bool max, Weft_IntX x, Weft_IntX y)
+{
+	Weft_IntX swap = max ? _mm256_cmpgt_epi64(y, x) : _mm256_cmpgt_epi64(x, y);
+	return _mm256_blendv_epi8(x, y, swap);
+}
+
+static Weft_IntX u32x_load(const uint32_t *src, size_t step)
+{
+	return step ? intx_load(src) : _mm256_set1_epi32(*src);
+}
+
+static bool u32x_supports(Weft_VecOp op)
+{
+	return op != WEFT_VEC_DIV;
+}
+
+static Weft_IntX u32x_apply(Weft_VecOp op, Weft_IntX x, Weft_IntX y)
+{
+	Weft_IntX bias = _mm256_set1_epi32(INT32_MIN);
+	Weft_IntX one = _mm256_set1_epi32(1);
+
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return _mm256_add_epi32(x, y);
+	case WEFT_VEC_SUB:
+		return _mm256_sub_epi32(x, y);
+	case WEFT_VEC_MUL:
+		return _mm256_mullo_epi32(x, y);
+	case WEFT_VEC_LT:
+		return _mm256_and_si256(
+			_mm256_cmpgt_epi32(_mm256_xor_si256(y, bias),
+		                       _mm256_xor_si256(x, bias)),
+			one);
+	case WEFT_VEC_EQ:
+		return _mm256_and_si256(_mm256_cmpeq_epi32(x, y), one);
+	default:
+		return x;
+	}
+}
+
+static Weft_IntX u32x_pick(bool max, Weft_IntX x, Weft_IntX y)
+{
+	return max ? _mm256_max_epu32(x, y) : _mm256_min_epu32(x, y);
+}
+#elif defined(WEFT_VEC_SSE2)
+static Weft_F64x f64x_load(const double *src, size_t step)
+{
+	return step ? _mm_loadu_pd(src) : _mm_set1_pd(*src);
+}
+
+static void f64x_store(double *dst, Weft_F64x x)
+{
+	_mm_storeu_pd(dst, x);
+}
+
+static Weft_F64x f64x_apply(Weft_VecOp op, Weft_F64x x, Weft_F64x y)
+{
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return _mm_add_pd(x, y);
+	case WEFT_VEC_SUB:
+		return _mm_sub_pd(x, y);
+	case WEFT_VEC_MUL:
+		return _mm_mul_pd(x, y);
+	case WEFT_VEC_DIV:
+		return _mm_div_pd(x, y);
+	case WEFT_VEC_LT:
+		return _mm_and_pd(_mm_cmplt_pd(x, y), _mm_set1_pd(1.0));
+	case WEFT_VEC_EQ:
+		return _mm_and_pd(_mm_cmpeq_pd(x, y), _mm_set1_pd(1.0));
+	}
+	return x;
+}
+
+static Weft_F64x f64x_pick(bool max, Weft_F64x x, Weft_F64x y)
+{
+	return max ? _mm_max_pd(x, y) : _mm_min_pd(x, y);
+}
+
+static Weft_IntX intx_load(const void *src)
+{
+	return _mm_loadu_si128(src);
+}
+
+static void intx_store(void *dst, Weft_IntX x)
+{
+	_mm_storeu_si128(dst, x);
+}
+
+static Weft_IntX i64x_load(const long *src, size_t step)
+{
+	return step ? intx_load(src) : _mm_set1_epi64x(*src);
+}
+
+static bool i64x_supports(Weft_VecOp op)
+{
+	return op == WEFT_VEC_ADD || op == WEFT_VEC_SUB;
+}
+
+static Weft_IntX i64x_apply(Weft_VecOp op, Weft_IntX x, Weft_IntX y)
+{
+	return (op == WEFT_VEC_ADD) ? _mm_add_epi64(x, y) : _mm_sub_epi64(x, y);
+}
+
+static Weft_IntX u32x_load(const uint32_t *src, size_t step)
+{
+	return step ? intx_load(src) : _mm_set1_epi32(*src);
+}
+
+static bool u32x_supports(Weft_VecOp op)
+{
+	return op != WEFT_VEC_MUL && op != WEFT_VEC_DIV;
+}
+
+static Weft_IntX u32x_apply(Weft_VecOp op, Weft_IntX x, Weft_IntX y)
+{
+	Weft_IntX bias = _mm_set1_epi32(INT32_MIN);
+	Weft_IntX one = _mm_set1_epi32(1);
+
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return _mm_add_epi32(x, y);
+	case WEFT_VEC_SUB:
+		return _mm_sub_epi32(x, y);
+	case WEFT_VEC_LT:
+		return _mm_and_si128(
+			_mm_cmplt_epi32(_mm_xor_si128(x, bias), _mm_xor_si128(y, bias)),
+			one);
+	case WEFT_VEC_EQ:
+		return _mm_and_si128(_mm_cmpeq_epi32(x, y), one);
+	default:
+		return x;
+	}
+}
+#endif
+
+static long *get_i64(const Weft_Vec *vec)
+{
+	return (long *)vec->data;
+}
+
+static double *get_f64(const Weft_Vec *vec)
+{
+	return (double *)vec->data;
+}
+
+static uint32_t *get_u32(const Weft_Vec *vec)
+{
+	return (uint32_t *)vec->data;
+}
+
+static size_t get_elem_size(Weft_VecType type)
+{
+	return (type == WEFT_VEC_U32) ? sizeof(uint32_t) : sizeof(uint64_t);
+}
+
+size_t vec_get_max_len(Weft_VecType type)
+{
+	return (PTRDIFF_MAX - sizeof(Weft_Vec)) / get_elem_size(type);
+}
+
+size_t vec_get_size(Weft_VecType type, size_t len)
+{
+	return sizeof(Weft_Vec) + len * get_elem_size(type);
+}
+
+Weft_Vec *new_vec(Weft_VecType type, size_t len)
+{
+	if (len > vec_get_max_len(type)) {
+		fprintf(stderr, "Failed to allocate vector of %zu elements\n", len);
+		exit(1);
+	}
+
+	Weft_Vec *vec = gc_alloc(vec_get_size(type, len));
+	vec->type = type;
+	vec->len = len;
+
+	return vec;
+}
+
+Weft_Vec *vec_from_data(Weft_VecType type, const Weft_Data *data, size_t len)
+{
+	Weft_Vec *vec = new_vec(type, len);
+	for (size_t i = 0; i < len; i++) {
+		vec_set(vec, i, data[i]);
+	}
+	return vec;
+}
+
+static int get_str_width(const char *ch, size_t left)
+{
+	int width = char_get_utf8_width(ch);
+	return (width > 0 && (size_t)width <= left) ? width : 0;
+}
+
+Weft_Vec *vec_from_str(const Weft_Str *str)
+{
+	const char *ch = str_get_ch(str);
+	size_t len = 0;
+
+	for (size_t i = 0; i < str->len; len++) {
+		int width = get_str_width(ch + i, str->len - i);
+		i += width ? width : 1;
+	}
+
+	Weft_Vec *vec = new_vec(WEFT_VEC_U32, len);
+	uint32_t *dst = get_u32(vec);
+
+	for (size_t i = 0; i < str->len;) {
+		int width = get_str_width(ch + i, str->len - i);
+		if (width) {
+			*dst++ = char_read_n(ch + i, width);
+			i += width;
+		} else {
+			*dst++ = (uint8_t)ch[i++];
+		}
+	}
+	return vec;
+}
+
+Weft_List *vec_to_list(const Weft_Vec *vec)
+{
+	Weft_List *list = NULL;
+	for (size_t i = vec->len; i > 0; i--) {
+		list = new_list_node(vec_get(vec, i - 1), list);
+	}
+	return list;
+}
+
+bool vec_accepts(Weft_VecType type, Weft_Data data)
+{
+	switch (data.type) {
+	case WEFT_DATA_INT:
+	case WEFT_DATA_CHAR:
+		return true;
+	case WEFT_DATA_FLOAT:
+		return type == WEFT_VEC_F64;
+	default:
+		return false;
+	}
+}
+
+static long get_inum(Weft_Data data)
+{
+	return (data.type == WEFT_DATA_CHAR) ? (long)data.cnum : data.inum;
+}
+
+static double get_fnum(Weft_Data data)
+{
+	return (data.type == WEFT_DATA_FLOAT) ? data.fnum : (double)get_inum(data);
+}
+
+Weft_Data vec_get(const Weft_Vec *vec, size_t index)
+{
+	switch (vec->type) {
+	case WEFT_VEC_I64:
+		return data_int(get_i64(vec)[index]);
+	case WEFT_VEC_F64:
+		return data_float(get_f64(vec)[index]);
+	case WEFT_VEC_U32:
+		return data_char(get_u32(vec)[index]);
+	}
+	return data_nil();
+}
+
+void vec_set(Weft_Vec *vec, size_t index, Weft_Data data)
+{
+	switch (vec->type) {
+	case WEFT_VEC_I64:
+		get_i64(vec)[index] = get_inum(data);
+		break;
+	case WEFT_VEC_F64:
+		get_f64(vec)[index] = get_fnum(data);
+		break;
+	case WEFT_VEC_U32:
+		get_u32(vec)[index] = get_inum(data);
+		break;
+	}
+}
+
+bool vec_has_zero(Weft_Data data)
+{
+	if (data.type != WEFT_DATA_VEC) {
+		return data.type != WEFT_DATA_FLOAT && !get_inum(data);
+	}
+
+	const Weft_Vec *vec = data.ptr;
+	for (size_t i = 0; i < vec->len; i++) {
+		if (vec->type == WEFT_VEC_I64 && !get_i64(vec)[i]) {
+			return true;
+		} else if (vec->type == WEFT_VEC_U32 && !get_u32(vec)[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static long get_i64_at(Weft_Data data, size_t index)
+{
+	if (data.type == WEFT_DATA_VEC) {
+		return get_i64(data.ptr)[index];
+	}
+	return get_inum(data);
+}
+
+bool vec_has_overflow(Weft_Data left, Weft_Data right)
+{
+	const Weft_Vec *vec = left.ptr;
+	if (left.type != WEFT_DATA_VEC) {
+		vec = right.ptr;
+	}
+
+	if (vec->type != WEFT_VEC_I64) {
+		return false;
+	}
+	for (size_t i = 0; i < vec->len; i++) {
+		if (get_i64_at(left, i) == LONG_MIN && get_i64_at(right, i) == -1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static long i64_apply(Weft_VecOp op, long x, long y)
+{
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return (long)((unsigned long)x + (unsigned long)y);
+	case WEFT_VEC_SUB:
+		return (long)((unsigned long)x - (unsigned long)y);
+	case WEFT_VEC_MUL:
+		return (long)((unsigned long)x * (unsigned long)y);
+	case WEFT_VEC_DIV:
+		return x / y;
+	case WEFT_VEC_LT:
+		return x < y;
+	case WEFT_VEC_EQ:
+		return x == y;
+	}
+	return x;
+}
+
+static double f64_apply(Weft_VecOp op, double x, double y)
+{
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return x + y;
+	case WEFT_VEC_SUB:
+		return x - y;
+	case WEFT_VEC_MUL:
+		return x * y;
+	case WEFT_VEC_DIV:
+		return x / y;
+	case WEFT_VEC_LT:
+		return x < y;
+	case WEFT_VEC_EQ:
+		return x == y;
+	}
+	return x;
+}
+
+static uint32_t u32_apply(Weft_VecOp op, uint32_t x, uint32_t y)
+{
+	switch (op) {
+	case WEFT_VEC_ADD:
+		return x + y;
+	case WEFT_VEC_SUB:
+		return x - y;
+	case WEFT_VEC_MUL:
+		return x * y;
+	case WEFT_VEC_DIV:
+		return x / y;
+	case WEFT_VEC_LT:
+		return x < y;
+	case WEFT_VEC_EQ:
+		return x == y;
+	}
+	return x;
+}
+
+static void apply_i64(Weft_VecOp op,
+                      long *dst,
+                      const long *left,
+                      size_t left_step,
+                      const long *right,
+                      size_t right_step,
+                      size_t len)
+{
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	for (; i64x_supports(op) && i + I64_LANES <= len; i += I64_LANES) {
+		Weft_IntX x = i64x_load(left + i * left_step, left_step);
+		Weft_IntX y = i64x_load(right + i * right_step, right_step);
+		intx_store(dst + i, i64x_apply(op, x, y));
+	}
+#endif
+	for (; i < len; i++) {
+		dst[i] = i64_apply(op, left[i * left_step], right[i * right_step]);
+	}
+}
+
+static void apply_f64(Weft_VecOp op,
+                      double *dst,
+                      const double *left,
+                      size_t left_step,
+                      const double *right,
+                      size_t right_step,
+                      size_t len)
+{
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	for (; i + F64_LANES <= len; i += F64_LANES) {
+		Weft_F64x x = f64x_load(left + i * left_step, left_step);
+		Weft_F64x y = f64x_load(right + i * right_step, right_step);
+		f64x_store(dst + i, f64x_apply(op, x, y));
+	}
+#endif
+	for (; i < len; i++) {
+		dst[i] = f64_apply(op, left[i * left_step], right[i * right_step]);
+	}
+}
+
+static void apply_u32(Weft_VecOp op,
+                      uint32_t *dst,
+                      const uint32_t *left,
+                      size_t left_step,
+                      const uint32_t *right,
+                      size_t right_step,
+                      size_t len)
+{
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	for (; u32x_supports(op) && i + U32_LANES <= len; i += U32_LANES) {
+		Weft_IntX x = u32x_load(left + i * left_step, left_step);
+		Weft_IntX y = u32x_load(right + i * right_step, right_step);
+		intx_store(dst + i, u32x_apply(op, x, y));
+	}
+#endif
+	for (; i < len; i++) {
+		dst[i] = u32_apply(op, left[i * left_step], right[i * right_step]);
+	}
+}
+
+static const void *
+get_operand(Weft_VecScalar *scalar, Weft_VecType type, Weft_Data data)
+{
+	if (data.type == WEFT_DATA_VEC) {
+		return ((const Weft_Vec *)data.ptr)->data;
+	}
+
+	switch (type) {
+	case WEFT_VEC_I64:
+		scalar->i64 = get_inum(data);
+		break;
+	case WEFT_VEC_F64:
+		scalar->f64 = get_fnum(data);
+		break;
+	case WEFT_VEC_U32:
+		scalar->u32 = get_inum(data);
+		break;
+	}
+	return scalar;
+}
+
+Weft_Vec *vec_apply(Weft_VecOp op, Weft_Data left, Weft_Data right)
+{
+	const Weft_Vec *src = (left.type == WEFT_DATA_VEC) ? left.ptr : right.ptr;
+	Weft_Vec *vec = new_vec(src->type, src->len);
+
+	Weft_VecScalar left_scalar;
+	Weft_VecScalar right_scalar;
+	const void *x = get_operand(&left_scalar, src->type, left);
+	const void *y = get_operand(&right_scalar, src->type, right);
+	size_t x_step = (left.type == WEFT_DATA_VEC);
+	size_t y_step = (right.type == WEFT_DATA_VEC);
+
+	switch (src->type) {
+	case WEFT_VEC_I64:
+		apply_i64(op, get_i64(vec), x, x_step, y, y_step, vec->len);
+		break;
+	case WEFT_VEC_F64:
+		apply_f64(op, get_f64(vec), x, x_step, y, y_step, vec->len);
+		break;
+	case WEFT_VEC_U32:
+		apply_u32(op, get_u32(vec), x, x_step, y, y_step, vec->len);
+		break;
+	}
+	return vec;
+}
+
+static long sum_i64(const long *src, size_t len)
+{
+	unsigned long sum = 0;
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	Weft_IntX acc = i64x_load((const long *)&sum, 0);
+	for (; i + I64_LANES <= len; i += I64_LANES) {
+		acc = i64x_apply(WEFT_VEC_ADD, acc, i64x_load(src + i, 1));
+	}
+
+	unsigned long lane[I64_LANES];
+	intx_store(lane, acc);
+	for (unsigned j = 0; j < I64_LANES; j++) {
+		sum += lane[j];
+	}
+#endif
+	for (; i < len; i++) {
+		sum += (unsigned long)src[i];
+	}
+	return (long)sum;
+}
+
+static double
+dot_f64(const double *left, const double *right, size_t right_step, size_t len)
+{
+	double sum = 0;
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	Weft_F64x acc = f64x_load(&sum, 0);
+	for (; i + F64_LANES <= len; i += F64_LANES) {
+		Weft_F64x x = f64x_apply(WEFT_VEC_MUL,
+		                         f64x_load(left + i, 1),
+		                         f64x_load(right + i * right_step, right_step));
+		acc = f64x_apply(WEFT_VEC_ADD, acc, x);
+	}
+
+	double lane[F64_LANES];
+	f64x_store(lane, acc);
+	for (unsigned j = 0; j < F64_LANES; j++) {
+		sum += lane[j];
+	}
+#endif
+	for (; i < len; i++) {
+		sum += left[i] * right[i * right_step];
+	}
+	return sum;
+}
+
+Weft_Data vec_sum(const Weft_Vec *vec)
+{
+	static const double one = 1.0;
+
+	switch (vec->type) {
+	case WEFT_VEC_I64:
+		return data_int(sum_i64(get_i64(vec), vec->len));
+	case WEFT_VEC_F64:
+		return data_float(dot_f64(get_f64(vec), &one, 0, vec->len));
+	case WEFT_VEC_U32: {
+		const uint32_t *src = get_u32(vec);
+		unsigned long sum = 0;
+		for (size_t i = 0; i < vec->len; i++) {
+			sum += src[i];
+		}
+		return data_int((long)sum);
+	}
+	}
+	return data_nil();
+}
+
+static long pick_i64(bool max, const long *src, size_t len)
+{
+	long best = src[0];
+	size_t i = 1;
+#ifdef WEFT_VEC_AVX2
+	if (len >= I64_LANES) {
+		Weft_IntX acc = i64x_load(src, 1);
+		for (i = I64_LANES; i + I64_LANES <= len; i += I64_LANES) {
+			acc = i64x_pick(max, acc, i64x_load(src + i, 1));
+		}
+
+		long lane[I64_LANES];
+		intx_store(lane, acc);
+		for (unsigned j = 0; j < I64_LANES; j++) {
+			best = (max ? lane[j] > best : lane[j] < best) ? lane[j] : best;
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		best = (max ? src[i] > best : src[i] < best) ? src[i] : best;
+	}
+	return best;
+}
+
+static double pick_f64(bool max, const double *src, size_t len)
+{
+	double best = src[0];
+	size_t i = 1;
+#ifdef WEFT_VEC_SIMD
+	if (len >= F64_LANES) {
+		Weft_F64x acc = f64x_load(src, 1);
+		for (i = F64_LANES; i + F64_LANES <= len; i += F64_LANES) {
+			acc = f64x_pick(max, acc, f64x_load(src + i, 1));
+		}
+
+		double lane[F64_LANES];
+		f64x_store(lane, acc);
+		for (unsigned j = 0; j < F64_LANES; j++) {
+			best = (max ? lane[j] > best : lane[j] < best) ? lane[j] : best;
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		best = (max ? src[i] > best : src[i] < best) ? src[i] : best;
+	}
+	return best;
+}
+
+static uint32_t pick_u32(bool max, const uint32_t *src, size_t len)
+{
+	uint32_t best = src[0];
+	size_t i = 1;
+#ifdef WEFT_VEC_AVX2
+	if (len >= U32_LANES) {
+		Weft_IntX acc = u32x_load(src, 1);
+		for (i = U32_LANES; i + U32_LANES <= len; i += U32_LANES) {
+			acc = u32x_pick(max, acc, u32x_load(src + i, 1));
+		}
+
+		uint32_t lane[U32_LANES];
+		intx_store(lane, acc);
+		for (unsigned j = 0; j < U32_LANES; j++) {
+			best = (max ? lane[j] > best : lane[j] < best) ? lane[j] : best;
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		best = (max ? src[i] > best : src[i] < best) ? src[i] : best;
+	}
+	return best;
+}
+
+static Weft_Data pick(bool max, const Weft_Vec *vec)
+{
+	switch (vec->type) {
+	case WEFT_VEC_I64:
+		return data_int(pick_i64(max, get_i64(vec), vec->len));
+	case WEFT_VEC_F64:
+		return data_float(pick_f64(max, get_f64(vec), vec->len));
+	case WEFT_VEC_U32:
+		return data_char(pick_u32(max, get_u32(vec), vec->len));
+	}
+	return data_nil();
+}
+
+Weft_Data vec_min(const Weft_Vec *vec)
+{
+	return pick(false, vec);
+}
+
+Weft_Data vec_max(const Weft_Vec *vec)
+{
+	return pick(true, vec);
+}
+
+Weft_Data vec_dot(const Weft_Vec *left, const Weft_Vec *right)
+{
+	unsigned long sum = 0;
+
+	switch (left->type) {
+	case WEFT_VEC_I64:
+		for (size_t i = 0; i < left->len; i++) {
+			sum += (unsigned long)get_i64(left)[i]
+			     * (unsigned long)get_i64(right)[i];
+		}
+		return data_int((long)sum);
+	case WEFT_VEC_F64:
+		return data_float(
+			dot_f64(get_f64(left), get_f64(right), 1, left->len));
+	case WEFT_VEC_U32:
+		for (size_t i = 0; i < left->len; i++) {
+			sum += (unsigned long)get_u32(left)[i] * get_u32(right)[i];
+		}
+		return data_int((long)sum);
+	}
+	return data_nil();
+}
+
+static void scan_i64(long *dst, const long *src, size_t len)
+{
+	unsigned long sum = 0;
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	__m128i carry = _mm_setzero_si128();
+	for (; i + 2 <= len; i += 2) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+		x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi64(x, carry);
+		_mm_storeu_si128((__m128i *)(dst + i), x);
+		carry = _mm_unpackhi_epi64(x, x);
+	}
+	sum = i ? (unsigned long)dst[i - 1] : 0;
+#endif
+	for (; i < len; i++) {
+		sum += (unsigned long)src[i];
+		dst[i] = (long)sum;
+	}
+}
+
+static void scan_u32(uint32_t *dst, const uint32_t *src, size_t len)
+{
+	uint32_t sum = 0;
+	size_t i = 0;
+#ifdef WEFT_VEC_SIMD
+	__m128i carry = _mm_setzero_si128();
+	for (; i + 4 <= len; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi32(x, carry);
+		_mm_storeu_si128((__m128i *)(dst + i), x);
+		carry = _mm_shuffle_epi32(x, 0xff);
+	}
+	sum = i ? dst[i - 1] : 0;
+#endif
+	for (; i < len; i++) {
+		sum += src[i];
+		dst[i] = sum;
+	}
+}
+
+Weft_Vec *vec_scan(const Weft_Vec *vec)
+{
+	Weft_Vec *dst = new_vec(vec->type, vec->len);
+
+	switch (vec->type) {
+	case WEFT_VEC_I64:
+		scan_i64(get_i64(dst), get_i64(vec), vec->len);
+		break;
+	case WEFT_VEC_F64: {
+		double sum = 0;
+		for (size_t i = 0; i < vec->len; i++) {
+			sum += get_f64(vec)[i];
+			get_f64(dst)[i] = sum;
+		}
+		break;
+	}
+	case WEFT_VEC_U32:
+		scan_u32(get_u32(dst), get_u32(vec), vec->len);
+		break;
+	}
+	return dst;
+}
+
+void vec_print(const Weft_Vec *vec)
+{
+	static const char *const prefix[] = {"#i64[", "#f64[", "#u32["};
+
+	printf("%s", prefix[vec->type]);
+	for (size_t i = 0; i < vec->len; i++) {
+		if (i) {
+			printf(" ");
+		}
+		data_print(vec_get(vec, i));
+	}
+	printf("]");
+}
@@ -0,0 +1,64 @@
+#ifndef WEFT_VEC_H
+#define WEFT_VEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward Declarations
+
+typedef struct weft_list Weft_List;
+typedef struct weft_str Weft_Str;
+typedef enum weft_vec_type Weft_VecType;
+typedef enum weft_vec_op Weft_VecOp;
+typedef struct weft_vec Weft_Vec;
+
+// Local Includes
+
+#include "data.h"
+
+// Data Types
+
+enum weft_vec_type {
+	WEFT_VEC_I64,
+	WEFT_VEC_F64,
+	WEFT_VEC_U32,
+};
+
+enum weft_vec_op {
+	WEFT_VEC_ADD,
+	WEFT_VEC_SUB,
+	WEFT_VEC_MUL,
+	WEFT_VEC_DIV,
+	WEFT_VEC_LT,
+	WEFT_VEC_EQ,
+};
+
+struct weft_vec {
+	Weft_VecType type;
+	size_t len;
+	uint64_t data[];
+};
+
+// Functions
+
+Weft_Vec *new_vec(Weft_VecType type, size_t len);
+Weft_Vec *vec_from_data(Weft_VecType type, const Weft_Data *data, size_t len);
+Weft_Vec *vec_from_str(const Weft_Str *str);
+Weft_List *vec_to_list(const Weft_Vec *vec);
+size_t vec_get_max_len(Weft_VecType type);
+size_t vec_get_size(Weft_VecType type, size_t len);
+bool vec_accepts(Weft_VecType type, Weft_Data data);
+Weft_Data vec_get(const Weft_Vec *vec, size_t index);
+void vec_set(Weft_Vec *vec, size_t index, Weft_Data data);
+bool vec_has_zero(Weft_Data data);
+bool vec_has_overflow(Weft_Data left, Weft_Data right);
+Weft_Vec *vec_apply(Weft_VecOp op, Weft_Data left, Weft_Data right);
+Weft_Data vec_sum(const Weft_Vec *vec);
+Weft_Data vec_min(const Weft_Vec *vec);
+Weft_Data vec_max(const Weft_Vec *vec);
+Weft_Data vec_dot(const Weft_Vec *left, const Weft_Vec *right);
+Weft_Vec *vec_scan(const Weft_Vec *vec);
+void vec_print(const Weft_Vec *vec);
+
+#endif
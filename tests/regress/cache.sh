@@ -0,0 +1,24 @@
+weft=$1
+tmp=$2
+
+rm -rf $tmp/cache
+mkdir -p $tmp/cache
+
+printf 'sq:\n\t{x -- x x} *\n5 sq print\n' > $tmp/cache.weft
+$weft --cache $tmp/cache $tmp/cache.weft
+$weft --cache $tmp/cache $tmp/cache.weft
+ls $tmp/cache | wc -l
+
+printf 'sq:\n\t{x -- x x} * 1 +\n5 sq print\n' > $tmp/cache.weft
+$weft --cache $tmp/cache $tmp/cache.weft
+ls $tmp/cache | wc -l
+
+$weft --cache $tmp/cache --inline 0 $tmp/cache.weft
+$weft --cache $tmp/cache --fold 0 $tmp/cache.weft
+ls $tmp/cache | wc -l
+
+for file in $tmp/cache/*; do
+	printf 'stale' > $file
+done
+$weft --cache $tmp/cache $tmp/cache.weft 2>&1 | sed 's/[0-9a-f]*\.weftc/*.weftc/'
+$weft --cache $tmp/cache $tmp/cache.weft
@@ -0,0 +1,24 @@
+weft=$1
+tmp=$2
+
+cat > $tmp/image.weft <<'END'
+sq:
+	{x -- x x} *
+table:
+	[["a" 1] ["b" 2]] dict
+0 6 range [sq] map print
+table "b" get print
+table "c" 3 put keys print
+[1 2 3] ivec 2 * print
+0 40 range list pvec 33 nth print
+"image" print
+END
+
+$weft $tmp/image.weft
+$weft --dump-image $tmp/image.img $tmp/image.weft
+$weft --image $tmp/image.img
+
+head -c 16 $tmp/image.img > $tmp/image-short.img
+$weft --image $tmp/image-short.img
+head -c 256 /dev/zero > $tmp/image-bad.img
+$weft --image $tmp/image-bad.img
@@ -0,0 +1,21 @@
+weft=$1
+tmp=$2
+
+cat > $tmp/intern.weft <<'END'
+pairs:
+	[[1 "a"] [2 "b"]]
+more:
+	[[1 "a"] [2 "b"]]
+pairs dict 3 "c" put keys print
+more dict keys print
+[1 2 3] array 4 push print
+[1 2 3] array print
+[1 2 3] 0 [+] fold [1 2 3] [{x -- x x} *] map cons print
+[[1 2] [1 2]] [[1 +] map] map print
+0 4 range [[1 2] array {n a -- a n} push] map print
+END
+
+$weft $tmp/intern.weft > $tmp/intern-off.out 2>&1
+$weft --intern $tmp/intern.weft > $tmp/intern-on.out 2>&1
+cat $tmp/intern-on.out
+diff $tmp/intern-off.out $tmp/intern-on.out && echo same
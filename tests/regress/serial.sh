@@ -0,0 +1,26 @@
+weft=$1
+tmp=$2
+
+cat > $tmp/serial-out.weft <<'END'
+sq:
+	{x -- x x} *
+[2 3] {t -- t t} 1 {t u x -- t x u} cons
+-7 9223372036854775807 2.5 'c' "text"
+[[4 5] [sq] {a b -- b a} +]
+[0 1 2] array 0 4 range list pvec [1 2 3] ivec
+[[1 "one"] [2 "two"]] dict
+END
+cat > $tmp/serial-in.weft <<'END'
+sq:
+	{x -- x x} *
+2 "three" put 1 del keys print
+print print print print print print print print print print print
+END
+
+$weft --out $tmp/serial.bin $tmp/serial-out.weft
+$weft --in $tmp/serial.bin $tmp/serial-in.weft
+
+printf 'WFTD\001\001\006\001\001\012\002\000' > $tmp/serial-self.bin
+$weft --in $tmp/serial-self.bin $tmp/serial-in.weft
+printf 'WFTD\001\001\006\001\006\002\000' > $tmp/serial-car.bin
+$weft --in $tmp/serial-car.bin $tmp/serial-in.weft